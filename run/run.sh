@@ -2,8 +2,9 @@ cd ../build &&
 make &&
 cp src/main ../run &&
 cp src/analyze ../run &&
+cp src/echoagent ../run &&
 cd ../run &&
-echo -n "Choose action (1. Simulate, 2. Analyze 3. Do nothing) > "
+echo -n "Choose action (1. Simulate, 2. Analyze 3. Do nothing 4. Transport benchmark) > "
 read num
 if [[ num -eq 1 ]]; then
   echo -n "How many times do you want to repeat simulation? > "
@@ -17,4 +18,6 @@ elif [[ num -eq 2 ]]; then
   ./analyze
 elif [[ num -eq 3 ]]; then
   echo "Program Compiled"
+elif [[ num -eq 4 ]]; then
+  mpirun -np 2 music echo.music
 fi
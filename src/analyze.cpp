@@ -1,17 +1,26 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include "environment.hh"
 
 int main(int argc, char const *argv[]) {
   std::string folder;
   bool LOAD = false;
   int action = 0;
-  double start = 0, end = 0;
+  double start = 0, end = 0,
+         overview = argc > 1 ? std::atof(argv[1]) : 0;  // Decimated level [Hz], 0 -> full resolution
+
+  // Value map cells: last (default), mean or count of the samples in them
+  ValueAggregate aggregate = VALUE_LAST;
+  if (argc > 2 && std::string(argv[2]) == "mean")
+    aggregate = VALUE_MEAN;
+  else if (argc > 2 && std::string(argv[2]) == "count")
+    aggregate = VALUE_COUNT;
 
   std::cout << "Insert folder name: ";
   std::cin >> folder;
   folder = "Simulations/" + folder + "/";
-  Plotter Plot(folder, LOAD);
+  Plotter Plot(folder, LOAD, overview, aggregate);
 
   std::cout << "\n1. Plot&Save Results\n2. Plot Zoomed Results\n3. View Simulation\n4. Exit" << std::endl;
   std::cout << "Choose action: ";
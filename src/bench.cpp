@@ -0,0 +1,297 @@
+/*
+ *  bench.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <armadillo>
+#include "include/controller.h"
+#include "include/episoderunner.h"
+#include "include/spikingagent.h"
+#include "include/loopback.h"
+#include "include/swarm.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Keeps the benchmarked results alive
+static volatile double sink;
+
+static void Report(const std::string& name, long steps, Clock::duration elapsed)
+{
+  double sec = std::chrono::duration<double>(elapsed).count();
+
+  std::cout << std::setw(25) << name
+            << std::setw(15) << steps
+            << std::setw(15) << sec
+            << std::setw(15) << steps/sec/1e6 << " MHz" << std::endl;
+}
+
+// Mean and worst latency of one stage per tick
+static void ReportLatency(const std::string& name, const std::vector<double>& lat)
+{
+  double mean = 0, worst = 0;
+
+  for (int i = 0; i < lat.size(); ++i) {
+    mean += lat[i]/lat.size();
+    worst = std::max(worst, lat[i]);
+  }
+
+  std::cout << std::setw(25) << name
+            << std::setw(15) << lat.size()
+            << std::setw(15) << mean*1e6 << " us mean"
+            << std::setw(15) << worst*1e6 << " us max" << std::endl;
+}
+
+// Combined 4-channel classical control step (altitude + 3 damping torques)
+static void BenchController(long steps)
+{
+  arma::vec q(12, arma::fill::zeros),
+            q_desired(12, arma::fill::zeros),
+            u(4, arma::fill::zeros);
+
+  q_desired(8) = 0.08;
+  Controller ctr(q_desired, 1000);
+
+  Clock::time_point start = Clock::now();
+  for (long i = 0; i < steps; ++i) {
+    q(0) = 1e-3*(i % 100);
+    q(8) = 1e-4*(i % 1000);
+    ctr.Control(q, u.memptr());
+    sink = u(0) + u(1);
+  }
+  Report("Controller::Control", steps, Clock::now() - start);
+}
+
+// Agent that answers every tick with a constant readout
+class IdleAgent : public Agent
+{
+public:
+  IdleAgent(double TICK) : t(0), tick(TICK) { value[0] = -100.0; value[1] = 0; }
+
+  double Time() { return t; }
+  void SendState(arma::vec& q, double tickt) {}
+  void SendReward(double reward, double tickt) {}
+  double Tick() { t += tick; return t; }
+  double GetAction(double tickt) { return 0; }
+  double GetDopa(double tickt) { return 0; }
+  double* GetValue(double tickt, double reward) { return value; }
+
+private:
+  double t, tick, value[2];
+};
+
+// Headless closed loop (plant + controller + idle agent), no recording
+static void BenchEpisode(double simt)
+{
+  arma::vec q0 = {0.2, -0.2, 0, 0, 0, 0, 0.04, 0.04, 0.01, 0.1, -0.3, 0},
+            q_desired(12, arma::fill::zeros);
+  double dynFreq = 1000, TICK = 0.01;
+
+  q_desired(8) = 0.08;
+  EpisodeRunner runner(q0, q_desired, dynFreq, TICK);
+  IdleAgent agent(TICK);
+
+  runner.Start(&agent, simt);
+
+  Clock::time_point start = Clock::now();
+  runner.Run();
+  Report("EpisodeRunner::Step", simt*dynFreq, Clock::now() - start);
+}
+
+// Independent idle bees stepped in lockstep on one time base
+static void BenchSwarm(double simt, int nBees)
+{
+  arma::vec q0 = {0.2, -0.2, 0, 0, 0, 0, 0.04, 0.04, 0.01, 0.1, -0.3, 0},
+            q_desired(12, arma::fill::zeros);
+  double dynFreq = 1000, TICK = 0.01;
+
+  q_desired(8) = 0.08;
+  IdleAgent clock(TICK);
+  Swarm swarm(&clock, simt);
+  std::vector<IdleAgent*> agents;
+  std::vector<EpisodeRunner*> runners;
+
+  for (int i = 0; i < nBees; ++i) {
+    agents.push_back(new IdleAgent(TICK));
+    runners.push_back(new EpisodeRunner(q0, q_desired, dynFreq, TICK));
+    runners[i]->Start(agents[i], simt);
+    swarm.Add(runners[i]);
+  }
+
+  Clock::time_point start = Clock::now();
+  while (swarm.Running())
+    swarm.Step();
+  Report("Swarm bee steps", simt*dynFreq*nBees, Clock::now() - start);
+
+  for (int i = 0; i < nBees; ++i) {
+    delete runners[i];
+    delete agents[i];
+  }
+}
+
+// Idle closed loop paced against the wall clock: can this host hold 1 kHz?
+static void BenchRealTime(double simt)
+{
+  arma::vec q0 = {0.2, -0.2, 0, 0, 0, 0, 0.04, 0.04, 0.01, 0.1, -0.3, 0},
+            q_desired(12, arma::fill::zeros);
+  double dynFreq = 1000, TICK = 0.01;
+
+  q_desired(8) = 0.08;
+  EpisodeRunner runner(q0, q_desired, dynFreq, TICK);
+  IdleAgent agent(TICK);
+  Pacer plant("plant", 1/dynFreq), neural("neural", TICK);
+
+  runner.SetPacing(&plant, &neural);
+  runner.Start(&agent, simt);
+
+  Clock::time_point start = Clock::now();
+  runner.Run();
+  Report("Real-time episode", simt*dynFreq, Clock::now() - start);
+  plant.Report(std::cout);
+  neural.Report(std::cout);
+}
+
+// Closed loop against the in-process spiking network (no MUSIC, no NEST)
+static void BenchSpikingAgent(double simt, bool pipelined, bool rates = false)
+{
+  arma::vec q0 = {0.2, -0.2, 0, 0, 0, 0, 0.04, 0.04, 0.01, 0.1, -0.3, 0},
+            q_desired(12, arma::fill::zeros);
+  double dynFreq = 1000, TICK = 0.01, pi = 3.1415926535897;
+
+  q_desired(8) = 0.08;
+  EpisodeRunner runner(q0, q_desired, dynFreq, TICK);
+
+  int pops_size[] = {50, 60, 100};
+  double value_param[] = {1.5, -100.0, 1.0},
+         policy_param[] = {3e-6, -3e-6},
+         dopa_param[] = {1, 0};
+  Receiver inhandler(pops_size, 3);
+  inhandler.SetCritic(0, value_param);
+  inhandler.SetActor(1, policy_param);
+  inhandler.SetDopa(2, dopa_param);
+
+  double ranges[] = {2*pi, -10};
+  int idState[] = {0,3},
+      resState[] = {7,15};
+  bool types[] = {true, false};
+  SpikingAgent agent(resState[0]*resState[1], pops_size, TICK, &inhandler);
+  Sender outhandler(&agent, TICK);
+  outhandler.CreatePlaceCells(2, idState, resState, types, ranges, 1000);
+  agent.SetSender(&outhandler);
+  if (rates)
+    outhandler.SetRateOutput(&agent, true, true);
+
+  runner.SetPipelined(pipelined);
+  runner.Start(&agent, simt);
+
+  Clock::time_point start = Clock::now();
+  runner.Run();
+  Clock::duration elapsed = Clock::now() - start;
+  Report(rates ? "SpikingAgent rates" : pipelined ? "SpikingAgent pipelined" : "SpikingAgent episode", simt*dynFreq, elapsed);
+  std::cout << std::setw(25) << "" << std::setw(15) << simt/std::chrono::duration<double>(elapsed).count()
+            << " x real time" << std::endl;
+}
+
+// Sender encode, loopback exchange and Receiver decode of each tick against
+// fixed-rate Poisson critic/actor/dopa spikes
+static void BenchLoopback(long ticks)
+{
+  double TICK = 0.01, pi = 3.1415926535897;
+  arma::vec q = {0.2, -0.2, 0, 0, 0, 0, 0.04, 0.04, 0.01, 0.1, -0.3, 0};
+
+  int pops_size[] = {50, 60, 100};
+  double rates[] = {20, 20, 10},
+         value_param[] = {1.5, -100.0, 1.0},
+         policy_param[] = {3e-6, -3e-6},
+         dopa_param[] = {1, 0};
+  Receiver inhandler(pops_size, 3);
+  inhandler.SetCritic(0, value_param);
+  inhandler.SetActor(1, policy_param);
+  inhandler.SetDopa(2, dopa_param);
+
+  PoissonResponder responder(pops_size, rates, 3);
+  LoopbackAgent agent(&responder, &inhandler, TICK);
+
+  double ranges[] = {2*pi, -10};
+  int idState[] = {0,3},
+      resState[] = {7,15};
+  bool types[] = {true, false};
+  Sender outhandler(&agent, TICK);
+  outhandler.CreatePlaceCells(2, idState, resState, types, ranges, 1000);
+  agent.SetSender(&outhandler);
+
+  std::vector<double> encode, exchange, decode;
+  double tickt = agent.Time();
+  for (long i = 0; i < ticks; ++i) {
+    q(0) = 0.2*std::sin(0.01*i);
+    q(3) = 2*std::cos(0.01*i);
+
+    Clock::time_point t0 = Clock::now();
+    agent.SendState(q, tickt);
+    agent.SendReward(10*std::sin(0.05*i), tickt);
+    Clock::time_point t1 = Clock::now();
+    tickt = agent.Tick();
+    Clock::time_point t2 = Clock::now();
+    sink = agent.GetAction(tickt) + agent.GetDopa(tickt) + agent.GetValue(tickt, 0)[0];
+    Clock::time_point t3 = Clock::now();
+
+    encode.push_back(std::chrono::duration<double>(t1 - t0).count());
+    exchange.push_back(std::chrono::duration<double>(t2 - t1).count());
+    decode.push_back(std::chrono::duration<double>(t3 - t2).count());
+  }
+
+  ReportLatency("Sender encode", encode);
+  ReportLatency("Loopback exchange", exchange);
+  ReportLatency("Receiver decode", decode);
+  std::cout << std::setw(25) << "" << std::setw(15) << responder.Received() << " events in"
+            << std::setw(15) << responder.Emitted() << " events out" << std::endl;
+}
+
+int main(int argc, char const *argv[]) {
+  long steps = argc > 1 ? std::stol(argv[1]) : 10000000;
+
+  std::cout << std::setw(25) << "Benchmark"
+            << std::setw(15) << "Steps"
+            << std::setw(15) << "Time [s]"
+            << std::setw(15) << "Rate" << std::endl;
+
+  BenchController(steps);
+  BenchEpisode(steps/1000);
+  BenchSwarm(steps/10000, 16);
+  BenchLoopback(steps/10000);
+  BenchRealTime(steps/10000000.0);
+
+  // Phase breakdown of the spiking closed loop only
+  Profiler::Reset();
+  BenchSpikingAgent(steps/1000000, false);
+#ifdef ROBOBEE_PROFILE
+  std::cout << std::endl;
+  Profiler::Report(std::cout);
+#endif
+
+  BenchSpikingAgent(steps/1000000, true);
+  BenchSpikingAgent(steps/1000000, false, true);
+
+  return 0;
+}
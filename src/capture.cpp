@@ -0,0 +1,122 @@
+/*
+ *  capture.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sstream>
+#include <csignal>
+#include "include/capture.h"
+
+FrameCapture::FrameCapture(const std::string& video, int _width, int _height, double fps, int buffers)
+{
+  width = _width;
+  height = _height;
+  captured = 0;
+  dropped = 0;
+  encoded = 0;
+  done = false;
+
+  pool.resize(buffers, std::vector<unsigned char>(width*height*3));
+  for (int i = 0; i < buffers; ++i)
+    free.push_back(i);
+
+  // OpenGL rows start from the bottom of the image
+  std::ostringstream cmd;
+  cmd << "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgb24"
+      << " -s " << width << "x" << height << " -r " << fps
+      << " -i - -vf vflip -pix_fmt yuv420p \"" << video << "\"";
+  // A dead encoder must not take the simulation down with it
+  signal(SIGPIPE, SIG_IGN);
+  encoder = popen(cmd.str().c_str(), "w");
+
+  worker = std::thread(&FrameCapture::Encode, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+  Close();
+}
+
+unsigned char* FrameCapture::Acquire()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (free.empty() || done) {
+    dropped++;
+    return NULL;
+  }
+
+  int slot = free.front();
+  free.pop_front();
+
+  return pool[slot].data();
+}
+
+void FrameCapture::Submit(unsigned char *frame)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (int i = 0; i < pool.size(); ++i)
+      if (pool[i].data() == frame)
+        queue.push_back(i);
+    captured++;
+  }
+  ready.notify_one();
+}
+
+void FrameCapture::Close()
+{
+  if (!worker.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    done = true;
+  }
+  ready.notify_one();
+  worker.join();
+
+  if (encoder)
+    pclose(encoder);
+  encoder = NULL;
+}
+
+void FrameCapture::Encode()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (true) {
+    ready.wait(lock, [this]{ return !queue.empty() || done; });
+    if (queue.empty())
+      break;
+
+    int slot = queue.front();
+    queue.pop_front();
+    lock.unlock();
+
+    bool ok = encoder && fwrite(pool[slot].data(), 1, pool[slot].size(), encoder) == pool[slot].size();
+
+    lock.lock();
+    free.push_back(slot);
+    if (ok)
+      encoded++;
+    else
+      dropped++;
+  }
+}
@@ -0,0 +1,314 @@
+/*
+ *  columnfile.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sstream>
+#include <climits>
+#include "include/columnfile.h"
+
+static const char columnMagic[8] = "RBCOLS1";
+
+ColumnWriter::ColumnWriter(const std::string& path, int columns, int blockSize, double rate, const std::string& names)
+{
+  std::string labels;
+  std::istringstream split(names);
+  std::string name;
+  int count = 0;
+
+  while (split >> name && count < columns) {
+    labels += name + '\0';
+    count++;
+  }
+  for (; count < columns; ++count) {
+    std::ostringstream def;
+    def << "col" << count;
+    labels += def.str() + '\0';
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, columnMagic, sizeof(header.magic));
+  header.dtype = FLOAT64;
+  header.columns = columns;
+  header.blockSize = blockSize;
+  header.rate = rate;
+  header.length = 0;
+  header.offset = (sizeof(header) + labels.size() + 7)/8*8;
+
+  file = fopen(path.c_str(), "wb");
+  if (file) {
+    std::vector<char> pad(header.offset - sizeof(header) - labels.size(), 0);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(labels.data(), 1, labels.size(), file);
+    fwrite(pad.data(), 1, pad.size(), file);
+  }
+
+  buffer.resize(columns*blockSize);
+}
+
+ColumnWriter::~ColumnWriter()
+{
+  Close();
+}
+
+void ColumnWriter::WriteBlock(const double *data, int samples)
+{
+  if (!file)
+    return;
+
+  int columns = header.columns;
+  for (int i = 0; i < columns; ++i)
+    for (int s = 0; s < samples; ++s)
+      buffer[i*samples + s] = data[s*columns + i];
+
+  fwrite(buffer.data(), sizeof(double), samples*columns, file);
+  header.length += samples;
+
+  // Keep the header valid for readers of a run still in progress
+  fseek(file, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, file);
+  fseek(file, 0, SEEK_END);
+  fflush(file);
+}
+
+void ColumnWriter::Close()
+{
+  if (!file)
+    return;
+
+  fclose(file);
+  file = NULL;
+}
+
+bool ColumnWriter::Save(const arma::mat& data, const std::string& path, double rate, const std::string& names)
+{
+  int length = data.n_rows > 0 ? data.n_rows : 1;
+  ColumnWriter writer(path, data.n_cols, length, rate, names);
+
+  if (!writer.file)
+    return false;
+
+  // data is column major already: one block
+  fwrite(data.memptr(), sizeof(double), data.n_elem, writer.file);
+  writer.header.length = data.n_rows;
+  fseek(writer.file, 0, SEEK_SET);
+  fwrite(&writer.header, sizeof(writer.header), 1, writer.file);
+  writer.Close();
+
+  return true;
+}
+
+bool ColumnWriter::Compact(const std::string& path)
+{
+  ColumnReader reader(path);
+  std::string names, tmp(path + ".tmp");
+  long samples;
+
+  if (!reader.IsOpen())
+    return false;
+  if (reader.header->length <= reader.header->blockSize || reader.header->length > INT_MAX)
+    return true;
+
+  for (int i = 0; i < reader.Columns(); ++i)
+    names += reader.Name(i) + ' ';
+
+  ColumnWriter writer(tmp, reader.Columns(), reader.Length(), reader.Rate(), names);
+  if (!writer.file)
+    return false;
+
+  for (int i = 0; i < reader.Columns(); ++i)
+    for (long b = 0, first = 0; first < reader.Length(); ++b, first += samples) {
+      const double *block = reader.Block(b, i, &samples);
+      fwrite(block, sizeof(double), samples, writer.file);
+    }
+  writer.header.length = reader.Length();
+  fseek(writer.file, 0, SEEK_SET);
+  fwrite(&writer.header, sizeof(writer.header), 1, writer.file);
+
+  bool ok = !ferror(writer.file);
+  ok = fclose(writer.file) == 0 && ok;
+  writer.file = NULL;
+
+  // The mapping of the old file stays valid until the reader goes
+  if (ok && std::rename(tmp.c_str(), path.c_str()) == 0)
+    return true;
+
+  std::remove(tmp.c_str());
+  return false;
+}
+
+ColumnReader::ColumnReader(const std::string& path)
+{
+  struct stat info;
+
+  base = NULL;
+  header = NULL;
+  size = 0;
+
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  if (fstat(fd, &info) == 0 && info.st_size >= sizeof(ColumnHeader)) {
+    size = info.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED)
+      base = (char*)map;
+  }
+
+  if (base) {
+    header = (const ColumnHeader*)base;
+
+    // Names between header and data, data within the file
+    bool valid = memcmp(header->magic, columnMagic, sizeof(columnMagic)) == 0 && header->dtype == FLOAT64 &&
+                 header->columns > 0 && header->blockSize > 0 &&
+                 header->offset >= sizeof(ColumnHeader) && header->offset <= size &&
+                 header->length <= (size - header->offset)/sizeof(double)/header->columns;
+
+    const char *name = base + sizeof(ColumnHeader), *end = base + (valid ? header->offset : 0);
+    for (int i = 0; valid && i < header->columns; ++i) {
+      const char *stop = (const char*)memchr(name, '\0', end - name);
+      if (!stop) {
+        valid = false;
+        break;
+      }
+      names.push_back(std::string(name, stop));
+      name = stop + 1;
+    }
+
+    if (!valid) {
+      munmap(base, size);
+      base = NULL;
+      header = NULL;
+      names.clear();
+    }
+  }
+}
+
+ColumnReader::~ColumnReader()
+{
+  if (base)
+    munmap(base, size);
+  if (fd >= 0)
+    close(fd);
+}
+
+int ColumnReader::Index(const std::string& name)
+{
+  for (int i = 0; i < names.size(); ++i)
+    if (names[i] == name)
+      return i;
+
+  return -1;
+}
+
+const double* ColumnReader::Block(int block, int col, long *samples)
+{
+  long first = (long)block*header->blockSize;
+
+  *samples = std::min<long>(header->blockSize, header->length - first);
+
+  return (const double*)(base + header->offset) + first*header->columns + col*(*samples);
+}
+
+arma::vec ColumnReader::Column(int col)
+{
+  long samples;
+
+  if (header->length <= header->blockSize) {
+    const double *data = Block(0, col, &samples);
+    return arma::vec(const_cast<double*>(data), samples, false, true);
+  }
+
+  arma::vec out(header->length);
+  for (long b = 0, first = 0; first < header->length; ++b, first += samples) {
+    const double *data = Block(b, col, &samples);
+    memcpy(out.memptr() + first, data, samples*sizeof(double));
+  }
+
+  return out;
+}
+
+void ColumnReader::Load(arma::mat& data)
+{
+  long samples;
+
+  data.set_size(header->length, header->columns);
+  for (long b = 0, first = 0; first < header->length; ++b, first += samples)
+    for (int i = 0; i < header->columns; ++i) {
+      const double *block = Block(b, i, &samples);
+      memcpy(data.colptr(i) + first, block, samples*sizeof(double));
+    }
+}
+
+bool ColumnReader::SaveText(const std::string& path, bool channelRows)
+{
+  FILE *out = fopen(path.c_str(), "w");
+  long samples;
+
+  if (!out)
+    return false;
+
+  if (channelRows) {
+    for (int i = 0; i < header->columns; ++i) {
+      for (long b = 0, first = 0; first < header->length; ++b, first += samples) {
+        const double *col = Block(b, i, &samples);
+        for (long s = 0; s < samples; ++s)
+          fprintf(out, " %.10e", col[s]);
+      }
+      fputc('\n', out);
+    }
+    return fclose(out) == 0;
+  }
+
+  for (long b = 0, first = 0; first < header->length; ++b, first += samples) {
+    std::vector<const double*> cols(header->columns);
+    for (int i = 0; i < header->columns; ++i)
+      cols[i] = Block(b, i, &samples);
+    for (long s = 0; s < samples; ++s) {
+      for (int i = 0; i < header->columns; ++i)
+        fprintf(out, " %.10e", cols[i][s]);
+      fputc('\n', out);
+    }
+  }
+
+  return fclose(out) == 0;
+}
+
+bool LoadColumns(arma::mat& data, const std::string& name, int channels)
+{
+  ColumnReader reader(name + ".bin");
+
+  if (reader.IsOpen()) {
+    reader.Load(data);
+    return true;
+  }
+
+  if (!data.load(name + ".dat", arma::raw_ascii))
+    return false;
+
+  if (channels > 0 && data.n_rows == channels && data.n_cols != channels)
+    arma::inplace_trans(data);
+
+  return true;
+}
@@ -0,0 +1,243 @@
+/*
+ *  connfile.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+#include "include/connfile.h"
+
+static const char connMagic[8] = "RBCONN1";
+static const int connBlock = 4096;      // Records buffered by ConnWriter
+
+ConnWriter::ConnWriter(const std::string& path, ConnWeight weight)
+{
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, connMagic, sizeof(header.magic));
+  header.weight = weight;
+  header.record = 2*sizeof(int32_t) + 2*weight;
+  header.count = 0;
+
+  file = fopen(path.c_str(), "wb");
+  if (file)
+    fwrite(&header, sizeof(header), 1, file);
+
+  buffer.resize(connBlock*header.record);
+  used = 0;
+}
+
+ConnWriter::~ConnWriter()
+{
+  Close();
+}
+
+void ConnWriter::Append(int source, int target, double wStart, double wEnd)
+{
+  char *record = &buffer[used];
+  int32_t ids[] = {source, target};
+
+  memcpy(record, ids, sizeof(ids));
+  if (header.weight == CONN_FLOAT32) {
+    float w[] = {(float)wStart, (float)wEnd};
+    memcpy(record + sizeof(ids), w, sizeof(w));
+  }
+  else {
+    double w[] = {wStart, wEnd};
+    memcpy(record + sizeof(ids), w, sizeof(w));
+  }
+
+  header.count++;
+  used += header.record;
+  if (used == buffer.size())
+    Write();
+}
+
+void ConnWriter::Write()
+{
+  if (file)
+    fwrite(buffer.data(), 1, used, file);
+  used = 0;
+}
+
+void ConnWriter::Close()
+{
+  if (!file)
+    return;
+
+  Write();
+  fseek(file, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, file);
+  fclose(file);
+  file = NULL;
+}
+
+ConnReader::ConnReader(const std::string& path)
+{
+  struct stat info;
+
+  base = NULL;
+  header = NULL;
+  size = 0;
+
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  if (fstat(fd, &info) == 0 && info.st_size >= sizeof(ConnHeader)) {
+    size = info.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED)
+      base = (char*)map;
+  }
+
+  if (base) {
+    header = (const ConnHeader*)base;
+    if (memcmp(header->magic, connMagic, sizeof(connMagic)) != 0 ||
+        (header->weight != CONN_FLOAT32 && header->weight != CONN_FLOAT64) ||
+        header->record != 2*sizeof(int32_t) + 2*header->weight ||
+        sizeof(ConnHeader) + header->count*header->record > size) {
+      munmap(base, size);
+      base = NULL;
+      header = NULL;
+    }
+  }
+}
+
+ConnReader::~ConnReader()
+{
+  if (base)
+    munmap(base, size);
+  if (fd >= 0)
+    close(fd);
+}
+
+void ConnReader::Load(arma::mat& data)
+{
+  long count = header->count;
+
+  data.set_size(count, 4);
+  double *source = data.colptr(0), *target = data.colptr(1),
+         *wStart = data.colptr(2), *wEnd = data.colptr(3);
+  for (long i = 0; i < count; ++i) {
+    source[i] = Source(i);
+    target[i] = Target(i);
+    wStart[i] = Weight(i, false);
+    wEnd[i] = Weight(i, true);
+  }
+}
+
+void ConnReader::Csr(CsrMatrix& matrix, bool end)
+{
+  long count = header->count;
+  int lo = 0, hi = -1;
+
+  for (long i = 0; i < count; ++i) {
+    int s = Source(i);
+    if (i == 0 || s < lo)
+      lo = s;
+    if (i == 0 || s > hi)
+      hi = s;
+  }
+
+  matrix.firstRow = lo;
+  matrix.rows = hi - lo + 1;
+  matrix.rowPtr.assign(matrix.rows + 1, 0);
+  matrix.cols.resize(count);
+  matrix.values.resize(count);
+
+  // Counting sort by source, stable
+  for (long i = 0; i < count; ++i)
+    matrix.rowPtr[Source(i) - lo + 1]++;
+  for (int r = 0; r < matrix.rows; ++r)
+    matrix.rowPtr[r + 1] += matrix.rowPtr[r];
+
+  std::vector<int> next(matrix.rowPtr.begin(), matrix.rowPtr.end() - 1);
+  for (long i = 0; i < count; ++i) {
+    int k = next[Source(i) - lo]++;
+    matrix.cols[k] = Target(i);
+    matrix.values[k] = Weight(i, end);
+  }
+}
+
+bool ConnReader::SaveText(const std::string& path)
+{
+  FILE *out = fopen(path.c_str(), "w");
+
+  if (!out)
+    return false;
+
+  for (long i = 0; i < header->count; ++i)
+    fprintf(out, "%d %d %.18e %.18e\n", Source(i), Target(i), Weight(i, false), Weight(i, true));
+
+  return fclose(out) == 0;
+}
+
+long ConvertConnections(const std::string& text, const std::string& path, ConnWeight weight)
+{
+  FILE *in = fopen(text.c_str(), "r");
+  if (!in)
+    return -1;
+
+  ConnWriter writer(path, weight);
+  if (!writer.IsOpen()) {
+    fclose(in);
+    return -1;
+  }
+
+  // One synapse per line, lines with less than four values are skipped
+  std::vector<char> line(4096);
+  long count = 0;
+  while (fgets(line.data(), line.size(), in)) {
+    double v[4];
+    char *p = line.data(), *next;
+    int n = 0;
+    for (; n < 4; ++n, p = next) {
+      v[n] = strtod(p, &next);
+      if (next == p)
+        break;
+    }
+    if (n < 4)
+      continue;
+
+    writer.Append((int)v[0], (int)v[1], v[2], v[3]);
+    count++;
+  }
+
+  fclose(in);
+  writer.Close();
+
+  return count;
+}
+
+bool LoadConnections(arma::mat& data, const std::string& name)
+{
+  ConnReader reader(name + ".bin");
+
+  if (reader.IsOpen()) {
+    reader.Load(data);
+    return true;
+  }
+
+  return data.load(name + ".dat", arma::raw_ascii);
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include "include/columnfile.h"
+#include "include/connfile.h"
+
+// Convert binary outputs (.bin) to text (.dat, one sample or synapse per
+// line, or one channel per line with -t) and network connection files
+// (.dat) to binary (.bin)
+int main(int argc, char const *argv[]) {
+  bool channelRows = argc > 1 && std::string(argv[1]) == "-t";
+  int first = channelRows ? 2 : 1;
+
+  if (argc <= first) {
+    std::cout << "Usage: " << argv[0] << " [-t] file.bin|connTo*.dat [...]" << std::endl;
+    std::cout << "  -t  write column files with one channel per line (old layout)" << std::endl;
+    return 1;
+  }
+
+  for (int i = first; i < argc; ++i) {
+    std::string path(argv[i]), out(path),
+                base(path.substr(path.find_last_of('/') + 1));
+    if (out.size() > 4 && out.compare(out.size() - 4, 4, ".dat") == 0) {
+      out.replace(out.size() - 4, 4, ".bin");
+      if (base.compare(0, 6, "connTo") != 0) {
+        std::cout << path << ": only connection files (connTo*.dat) are converted to binary" << std::endl;
+        continue;
+      }
+      ColumnReader column(out);
+      if (column.IsOpen()) {
+        std::cout << out << ": is a column file, not overwritten" << std::endl;
+        continue;
+      }
+      long count = ConvertConnections(path, out);
+      if (count < 0)
+        std::cout << path << ": conversion failed" << std::endl;
+      else
+        std::cout << path << ": " << count << " synapses" << std::endl;
+      continue;
+    }
+
+    if (out.size() > 4 && out.compare(out.size() - 4, 4, ".bin") == 0)
+      out.replace(out.size() - 4, 4, ".dat");
+    else
+      out += ".dat";
+
+    ConnReader conn(path);
+    if (conn.IsOpen()) {
+      std::cout << path << ": " << conn.Count() << " synapses" << std::endl;
+      if (!conn.SaveText(out))
+        std::cout << out << ": write failed" << std::endl;
+      continue;
+    }
+
+    ColumnReader reader(path);
+    if (!reader.IsOpen()) {
+      std::cout << path << ": not a column or connection file" << std::endl;
+      continue;
+    }
+
+    std::cout << path << ": " << reader.Length() << " samples";
+    for (int j = 0; j < reader.Columns(); ++j)
+      std::cout << " " << reader.Name(j);
+    std::cout << std::endl;
+
+    if (!reader.SaveText(out, channelRows))
+      std::cout << out << ": write failed" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ *  echo.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+// Stand-in for the BeeBrain (run/bee.py) in transport benchmarks: takes the
+// place cell spikes on p_in and answers on p_out with synthetic readout
+// spikes, so the closed loop costs MUSIC/MPI and the environment only.
+// Application parameters (sim.music, see run/echo.music):
+//   pattern  -> poisson (default), regular, echo (one spike back for every
+//               spike received) or silent
+//   rate     -> readout rate [Hz] of every channel (default 20)
+//   critic_rate, actor_rate, dopa_rate -> rate of the BeeBrain populations
+//               (50, 60, 100 channels after each other), default rate
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#include <mpi.h>
+#include <music.hh>
+#include "include/eventport.h"
+#include "include/musicport.h"
+#include "include/encoder.h"
+
+#define TICK (0.01)
+
+// Counts the input spikes of a tick, keeps their channels for the echo
+class EchoInput : public EventInput
+{
+public:
+  EchoInput(bool _keep) : keep(_keep), received(0) {}
+
+  void HandleEvent(double t, int id)
+  {
+    received++;
+    if (keep)
+      ids.push_back(id);
+  }
+
+  bool keep;
+  long received;
+  std::vector<int> ids;
+};
+
+// Channels [first, first+count) of width divided evenly over the ranks
+static void Partition(int width, int nProcs, int rank, int& first, int& count)
+{
+  int rest = width % nProcs;
+
+  count = width / nProcs;
+  first = count * rank;
+  if (rank < rest) {
+    first += rank;
+    count += 1;
+  } else
+  first += rest;
+}
+
+int main(int argc, char **argv)
+{
+    MUSIC::Setup* setup = new MUSIC::Setup (argc, argv);
+
+    double simt, rate = 20;
+    std::string pattern = "poisson";
+    setup->config("simtime", &simt);
+    setup->config("pattern", &pattern);
+    setup->config("rate", &rate);
+
+    // BeeBrain populations [critic, actor, dopa]
+    int pops_size[] = {50, 60, 100};
+    double pops_rate[] = {rate, rate, rate};
+    setup->config("critic_rate", &pops_rate[0]);
+    setup->config("actor_rate", &pops_rate[1]);
+    setup->config("dopa_rate", &pops_rate[2]);
+
+    MUSIC::EventInputPort *indata = setup->publishEventInput("p_in");
+    MUSIC::EventOutputPort *outdata = setup->publishEventOutput("p_out");
+
+    MPI::Intracomm comm = setup->communicator();
+    int nProcs = comm.Get_size();
+    int rank = comm.Get_rank();
+
+    int inFirst, inCount, outFirst, outCount;
+    Partition(indata->width(), nProcs, rank, inFirst, inCount);
+    Partition(outdata->width(), nProcs, rank, outFirst, outCount);
+
+    // Rate of every local output channel
+    std::vector<double> rates(outCount, rate);
+    for (int i = 0, first = 0; i < 3; first += pops_size[i++])
+      for (int id = std::max(first, outFirst); id < std::min(first + pops_size[i], outFirst + outCount); ++id)
+        rates[id - outFirst] = pops_rate[i];
+
+    bool echo = pattern == "echo",
+         regular = pattern == "regular",
+         silent = pattern == "silent";
+    if (!echo && !regular && !silent && pattern != "poisson") {
+      if (rank == 0)
+        std::cerr << "echoagent: unknown pattern " << pattern << std::endl;
+      comm.Abort(1);
+    }
+
+    MUSIC::LinearIndex outindex(outFirst, outCount);
+    MUSIC::LinearIndex inindex(inFirst, inCount);
+    MusicEventOutput outport(outdata);
+    EchoInput input(echo);
+    MusicEventInput inport(&input);
+    outdata->map(&outindex, MUSIC::Index::GLOBAL);
+    indata->map(&inindex, &inport, 0.0, 1);
+
+    Encoder spikeGen(TICK);
+    std::vector<double> next(outCount);   // Regular pattern: next spike per channel
+    for (int i = 0; i < outCount; ++i)
+      next[i] = rates[i] > 0 ? (double)(outFirst + i) / outdata->width() / rates[i] : simt;
+
+    MUSIC::Runtime *runtime = new MUSIC::Runtime(setup, TICK);
+
+    long ticks = 0, sent = 0;
+    double t;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while ((t = runtime->time()) < simt) {
+
+      if (echo && outCount > 0) {
+        for (int i = 0; i < input.ids.size(); ++i)
+          outport.InsertEvent(t, outFirst + input.ids[i] % outCount);
+        sent += input.ids.size();
+        input.ids.clear();
+      }
+      else if (regular) {
+        for (int i = 0; i < outCount; ++i)
+          for (; rates[i] > 0 && next[i] < t + TICK; next[i] += 1/rates[i], ++sent)
+            outport.InsertEvent(next[i], outFirst + i);
+      }
+      else if (!silent) {
+        EventCounter counter(&outport);
+        for (int i = 0; i < outCount; ++i)
+          if (rates[i] > 0)
+            spikeGen.PoissonSpikeGenerator(&counter, rates[i], t, outFirst + i);
+        sent += counter.Take();
+      }
+
+      runtime->tick();
+      ticks++;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Totals over the ranks
+    long local[] = {sent, input.received}, total[2];
+    double slowest;
+    comm.Allreduce(local, total, 2, MPI::LONG, MPI::SUM);
+    comm.Allreduce(&elapsed, &slowest, 1, MPI::DOUBLE, MPI::MAX);
+
+    runtime->finalize();
+
+    if (rank == 0)
+      std::cout << "echoagent: " << pattern << " " << ticks << " ticks in " << slowest << " s ("
+                << ticks/slowest << " ticks/s, " << simt/slowest << " x real time), "
+                << total[0] << " spikes sent, " << total[1] << " received" << std::endl;
+
+    delete runtime;
+
+    return 0;
+}
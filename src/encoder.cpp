@@ -40,12 +40,22 @@ Encoder::~Encoder()
   delete numberGenerator;
 }
 
-void Encoder::PoissonSpikeGenerator(MUSIC::EventOutputPort* outport, double rate, double tickt, int index)
+void Encoder::PoissonSpikeGenerator(EventOutput* outport, double rate, double tickt, int index)
 {
   t = -log((*numberGenerator)())/rate;
 
   while (t<winLength) {
-      outport -> insertEvent(tickt+t, MUSIC::GlobalIndex(index));
+      outport -> InsertEvent(tickt+t, index);
       t = t - log((*numberGenerator)())/rate;
   }
 }
+
+void Encoder::Save(std::ostream& out)
+{
+  PutEngine(out, *generator);
+}
+
+void Encoder::Load(std::istream& in)
+{
+  GetEngine(in, *generator);
+}
@@ -27,6 +27,21 @@
 #include "include/sender.h"
 #include "include/receiver.h"
 #include "include/iomanager.h"
+#include "include/episoderunner.h"
+#include "include/recorder.h"
+#include "include/columnfile.h"
+#include "include/connfile.h"
+#include "include/telemetry.h"
+#include "include/checkpoint.h"
+#include "include/profiler.h"
+#include "include/pacer.h"
+#include "include/swarm.h"
+#include "include/musicagent.h"
+#include "include/musicport.h"
+#include "include/spikingagent.h"
+#include "include/loopback.h"
+#include "include/capture.h"
+#include "include/renderer.h"
 #include "include/plotter.h"
 
 #endif // ENVIRONMENT_H
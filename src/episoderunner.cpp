@@ -0,0 +1,628 @@
+/*
+ *  episoderunner.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "include/episoderunner.h"
+
+EpisodeRunner::EpisodeRunner(arma::vec& _q0, arma::vec& q_desired, double dynFreq, double _TICK)
+  : bee(_q0, dynFreq), ctr(q_desired, dynFreq)
+{
+  q0 = _q0;
+  q_d = q_desired;
+  q = q0;
+  u.zeros(4);
+
+  dynStep = 1/dynFreq;
+  TICK = _TICK;
+  simt = 0;
+
+  maxRew = 50;
+  sigma = 3.0;
+  thetaBound = 4*3.1415926535897;
+  omegaBound = 10;
+
+  agent = NULL;
+  manager = NULL;
+  recorder = NULL;
+  checkpointInterval = 0;
+  nextCheckpoint = 0;
+  agentOffset = 0;
+  telemetry = NULL;
+  plantPacer = NULL;
+  neuralPacer = NULL;
+  pipelined = false;
+  primed = false;
+  busy = false;
+  stop = false;
+  netControl = true;
+}
+
+EpisodeRunner::~EpisodeRunner()
+{
+  StopWorker();
+}
+
+void EpisodeRunner::SetReward(double _maxRew, double _sigma)
+{
+  maxRew = _maxRew;
+  sigma = _sigma;
+}
+
+void EpisodeRunner::SetBounds(double _thetaBound, double _omegaBound)
+{
+  thetaBound = _thetaBound;
+  omegaBound = _omegaBound;
+}
+
+void EpisodeRunner::SetLog(Iomanager *_manager)
+{
+  manager = _manager;
+}
+
+void EpisodeRunner::SetRecorder(Recorder *_recorder)
+{
+  recorder = _recorder;
+}
+
+void EpisodeRunner::SetTelemetry(Telemetry *_telemetry)
+{
+  telemetry = _telemetry;
+}
+
+void EpisodeRunner::SetPacing(Pacer *plant, Pacer *neural)
+{
+  plantPacer = plant;
+  neuralPacer = neural;
+}
+
+void EpisodeRunner::SetPipelined(bool _pipelined)
+{
+  pipelined = _pipelined;
+}
+
+void EpisodeRunner::SetNetControl(bool _netControl)
+{
+  netControl = _netControl;
+}
+
+void EpisodeRunner::Start(Agent *_agent, double _simt)
+{
+  agent = _agent;
+  simt = _simt;
+
+  q = q0;
+  bee.InitRobot(q);
+  ctr.Reset();
+  reward = Reward();
+
+  // Initialize
+  iter = 0;
+  trials = 0;
+
+  agentOffset = 0;
+  tickt = agent->Time();
+  nextCheckpoint = tickt + checkpointInterval;
+  dynTime = 0;
+  loadDopa = 1.0;
+  startSim = 2.0;
+  punishTime = -1.0;
+  clockStop = 1.0;
+  trialTime = 0;
+  prevRew = 0;
+  robotPos = 0;
+  thetaCheck = 0;
+  omegaCheck = 0;
+  cageBound = std::pow(q_d(8),2);
+  controlRate = 0.0;
+  cumulativeRew = 0.0;
+  succTrial = 0;
+
+  valueFunction = -100.0;
+  tdError = 0;
+  policy = 0;
+  dopaActivity = 0;
+
+  tickState = q;
+  tickRew = reward;
+  crashState.zeros(q.size());
+
+  primed = false;
+  if (pipelined && !worker.joinable()) {
+    stop = false;
+    worker = std::thread(&EpisodeRunner::Pipeline, this);
+  }
+
+  if (recorder) {
+    double rate = 1/dynStep;
+    recTime = recorder->AddChannel("simtime", 1, rate, "time");
+    recState = recorder->AddChannel("state", q.size(), rate, "theta1 theta2 theta3 omega1 omega2 omega3 x y z vx vy vz");
+    recControl = recorder->AddChannel("control", u.size(), rate, "lift tau1 tau2 tau3");
+    recNetwork = recorder->AddChannel("network", 3, rate, "value policy dopa", round(TICK/dynStep));
+    recEnvironment = recorder->AddChannel("environment", 2, rate, "reward tderror");
+  }
+
+  if (manager)
+    manager->Print() << std::setw(15) << "Trial"
+                     << std::setw(15) << "Start Time"
+                     << std::setw(15) << "End Time"
+                     << std::setw(15) << "Trial Time"
+                     << std::setw(15) << "Avg Reward"
+                     << std::setw(15) << "Control Rate" << std::endl;
+
+  if (plantPacer)
+    plantPacer->Start();
+}
+
+void EpisodeRunner::SetCheckpoint(const std::string& path, double interval)
+{
+  checkpointPath = path;
+  checkpointInterval = interval;
+}
+
+void EpisodeRunner::Step()
+{
+  {
+    PROFILE_SCOPE("step");
+    Complete(Prepare());
+  }
+
+  if (plantPacer)
+    plantPacer->Wait();
+}
+
+bool EpisodeRunner::Prepare()
+{
+  // 1000Hz Classical Controller calculates 3 control torques
+  {
+    PROFILE_SCOPE("control");
+    ctr.Control(q, u.memptr());
+  }
+
+  // 100Hz Neural Controller
+  bool tick = dynTime >= TICK && std::abs(remainder(dynTime,TICK)) < 0.00001;
+  if (tick)
+  {
+    if (neuralPacer)
+      neuralPacer->Release();
+
+    prevRew = tickRew;
+    if (tickt > startSim)
+      cumulativeRew += prevRew;
+
+    if (pipelined && primed) {
+      // Encoded by the worker during the last tick; its readout applies from now on
+      PROFILE_SCOPE("pipeline wait");
+      Collect();
+    }
+    else {
+      if (dynTime >= loadDopa) {
+        PROFILE_SCOPE("send state");
+        agent->SendState(tickState, tickt - agentOffset);
+      }
+
+      // Dopaminergic Neurons Stimulation
+      if (tdError >= 1000.0)
+        tdError = 1000.0;
+      else if (tdError <= -1000.0)
+        tdError = -1000.0;
+      {
+        PROFILE_SCOPE("send reward");
+        agent->SendReward(tdError, tickt - agentOffset);
+      }
+      primed = true;
+    }
+  }
+
+  return tick;
+}
+
+void EpisodeRunner::Complete(bool tick)
+{
+  bool ticked = false;
+
+  if (tick)
+  {
+    {
+      PROFILE_SCOPE("tick");
+      tickt = agent->Tick() + agentOffset;
+    }
+
+    if (pipelined) {
+      // Readout of this tick and encoding for the next one overlap the next
+      // TICK/dynStep plant steps
+      job.t = tickt - agentOffset;
+      job.reward = prevRew;
+      job.state = q;
+      job.sendState = dynTime + TICK >= loadDopa - dynStep/2;
+      job.zeroTd = dynTime > punishTime + TICK && dynTime <= startSim;
+      Post();
+    }
+    else {
+      {
+        PROFILE_SCOPE("readout");
+        policy = agent->GetAction(tickt - agentOffset);        // Policy
+        dopaActivity = agent->GetDopa(tickt - agentOffset);    // Dopaminergi neurons activity
+        value = agent->GetValue(tickt - agentOffset, prevRew); // Value Function and TD-error
+      }
+      valueFunction = value[0];
+      tdError = value[1];
+
+      if (dynTime > punishTime + TICK && dynTime <= startSim)
+        tdError = 0;
+    }
+
+    // State and reward the agent receives at the next tick
+    tickState = q;
+    tickRew = reward;
+    ticked = true;
+
+    if (neuralPacer)
+      neuralPacer->Complete();
+  }
+
+  // Recording
+  if (recorder) {
+    PROFILE_SCOPE("record");
+    double network[] = {valueFunction, policy, dopaActivity},
+           environment[] = {reward, tdError};
+    recorder->Record(recTime, &dynTime);
+    recorder->Record(recState, q.memptr());
+    recorder->Record(recControl, u.memptr());
+    recorder->Record(recNetwork, network);
+    recorder->Record(recEnvironment, environment);
+  }
+
+  if (telemetry) {
+    PROFILE_SCOPE("telemetry");
+    TelemetrySample sample;
+    sample.t = dynTime;
+    std::copy(q.memptr(), q.memptr() + 12, sample.q);
+    std::copy(u.memptr(), u.memptr() + 4, sample.u);
+    sample.reward = reward;
+    sample.tdError = tdError;
+    sample.value = valueFunction;
+    sample.policy = policy;
+    sample.dopa = dopaActivity;
+    sample.trials = trials;
+    telemetry->Publish(sample);
+  }
+
+  // Activate Neural Controller
+  if (netControl)
+    u(1) = controlRate*u(1) + policy;
+
+  // Environment (RoboBee) generates the new state and reward
+  {
+    PROFILE_SCOPE("dynamics");
+    q = bee.BeeDynamics(u);
+    reward = Reward();
+  }
+
+  // Check Boundaries
+  if (dynTime >= startSim){
+      robotPos = std::pow(q(6),2)/8 + std::pow(q(7),2)/8 + std::pow(q(8)-q_d(8),2);
+      thetaCheck = std::abs(q(0));
+      omegaCheck = std::abs(q(3));
+  }
+  // Crashing condition
+  if (thetaCheck > thetaBound || omegaCheck > omegaBound || robotPos > cageBound){
+    crashState = tickState;
+    trialTime = dynTime - startSim;
+    PrintTrial();
+    if (trialTime < 1.0)
+      controlRate += 0.01;
+    punishTime = tickt + TICK;
+    startSim = punishTime + clockStop;
+    trials++;
+    thetaCheck = 0;
+    omegaCheck = 0;
+    robotPos = 0;
+    cumulativeRew = 0;
+  }
+  else if (dynTime - startSim >= 10.0 && netControl) {
+    succTrial += 1;
+    // controlRate -= 0.01;
+    trialTime = dynTime - startSim;
+    PrintTrial();
+    startSim = tickt + TICK + clockStop;
+    trials++;
+    cumulativeRew = 0;
+  }
+
+  // Stop Simulation
+  if (dynTime <= punishTime + TICK){
+    q = crashState;
+    reward = -50;
+    bee.InitRobot(q);
+    ctr.Reset();
+  }
+  else if (dynTime > punishTime + TICK && dynTime <= startSim) {
+    q = q0;
+    bee.InitRobot(q);
+    ctr.Reset();
+  }
+
+  // Increment Counters
+  dynTime += dynStep;
+  iter++;
+
+  // Snapshot between two steps, right after a neural tick
+  if (ticked && checkpointInterval > 0 && tickt >= nextCheckpoint) {
+    PROFILE_SCOPE("checkpoint");
+    Checkpoint(checkpointPath);
+    nextCheckpoint += checkpointInterval;
+  }
+}
+
+void EpisodeRunner::Run()
+{
+  while (Running())
+    Step();
+
+  Finalize();
+}
+
+void EpisodeRunner::Finalize()
+{
+  StopWorker();
+  agent->Finalize();
+
+  if (recorder)
+    recorder->Close();
+}
+
+void EpisodeRunner::PrintTrial()
+{
+  if (!manager)
+    return;
+
+  manager->Print() << std::setw(15) << trials
+                   << std::setw(15) << startSim
+                   << std::setw(15) << dynTime
+                   << std::setw(15) << trialTime
+                   << std::setw(15) << controlRate
+                   << std::setw(15) << cumulativeRew/trialTime << std::endl;
+}
+
+// Snapshot framing; bump the magic whenever a Save layout changes (of the
+// runner, Robobee, Controller or an agent) so older files are refused
+static const char checkpointMagic[8] = "RBCKPT3", checkpointEnd[8] = "RBCKEND";
+
+void EpisodeRunner::SaveState(std::ostream& out)
+{
+  // Readout not applied yet, encoding for the next tick already delivered
+  bool ahead = pipelined && primed;
+
+  Put(out, ahead);
+  if (ahead) {
+    Put(out, job.policy);
+    Put(out, job.dopa);
+    Put(out, job.value);
+    Put(out, job.tdError);
+  }
+  PutMat(out, q);
+  PutMat(out, u);
+  PutMat(out, tickState);
+  PutMat(out, crashState);
+  Put(out, reward);
+  Put(out, tickRew);
+  Put(out, valueFunction);
+  Put(out, tdError);
+  Put(out, policy);
+  Put(out, dopaActivity);
+  Put(out, iter);
+  Put(out, trials);
+  Put(out, tickt);
+  Put(out, dynTime);
+  Put(out, startSim);
+  Put(out, punishTime);
+  Put(out, trialTime);
+  Put(out, prevRew);
+  Put(out, robotPos);
+  Put(out, thetaCheck);
+  Put(out, omegaCheck);
+  Put(out, controlRate);
+  Put(out, cumulativeRew);
+  Put(out, succTrial);
+  bee.Save(out);
+  ctr.Save(out);
+  agent->Save(out);
+}
+
+bool EpisodeRunner::LoadState(std::istream& in, uint64_t length)
+{
+  bool ahead;
+
+  // A pipelined snapshot has already encoded the next tick
+  Get(in, ahead);
+  if (!in || (ahead && !pipelined))
+    return false;
+
+  if (ahead) {
+    Get(in, job.policy);
+    Get(in, job.dopa);
+    Get(in, job.value);
+    Get(in, job.tdError);
+  }
+  primed = ahead;
+
+  GetMat(in, q);
+  GetMat(in, u);
+  GetMat(in, tickState);
+  GetMat(in, crashState);
+  Get(in, reward);
+  Get(in, tickRew);
+  Get(in, valueFunction);
+  Get(in, tdError);
+  Get(in, policy);
+  Get(in, dopaActivity);
+  Get(in, iter);
+  Get(in, trials);
+  Get(in, tickt);
+  Get(in, dynTime);
+  Get(in, startSim);
+  Get(in, punishTime);
+  Get(in, trialTime);
+  Get(in, prevRew);
+  Get(in, robotPos);
+  Get(in, thetaCheck);
+  Get(in, omegaCheck);
+  Get(in, controlRate);
+  Get(in, cumulativeRew);
+  Get(in, succTrial);
+  bee.Load(in);
+  ctr.Load(in);
+  agent->Load(in);
+
+  // The body must be consumed exactly (same layout as the writer)
+  return in && (uint64_t)in.tellg() == length;
+}
+
+bool EpisodeRunner::Checkpoint(const std::string& path)
+{
+  std::string tmp(path + ".tmp");
+  std::ostringstream out;
+
+  // The agent must not be touched by the worker while it is saved
+  Idle();
+  SaveState(out);
+
+  // Magic, body length, body and trailer: Restore refuses truncated files
+  std::string body(out.str());
+  std::ofstream file(tmp.c_str(), std::ios::binary);
+  file.write(checkpointMagic, 8);
+  Put(file, (uint64_t)body.size());
+  file.write(body.data(), body.size());
+  file.write(checkpointEnd, 8);
+  file.close();
+
+  // Replace the previous snapshot only once the new one is complete
+  return file && std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool EpisodeRunner::Restore(const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  uint64_t length = 0;
+
+  // Reject truncated or foreign files before any state is touched
+  if (data.size() < 24 || data.compare(0, 8, std::string(checkpointMagic, 8)) != 0)
+    return false;
+  std::memcpy(&length, &data[8], sizeof(length));
+  if (length != data.size() - 24 || data.compare(data.size() - 8, 8, std::string(checkpointEnd, 8)) != 0)
+    return false;
+
+  // The layout is only known to match once the body is read through: the
+  // current state is kept aside and put back when it does not
+  Idle();
+  std::ostringstream backup;
+  SaveState(backup);
+
+  std::istringstream in(data.substr(16, length));
+  if (!LoadState(in, length)) {
+    std::string saved(backup.str());
+    std::istringstream undo(saved);
+    LoadState(undo, saved.size());
+    return false;
+  }
+
+  // The agent may run on a fresh clock (new MUSIC runtime)
+  agentOffset = tickt - agent->Time();
+  nextCheckpoint = tickt + checkpointInterval;
+
+  // Real-time schedule restarts from here
+  if (plantPacer)
+    plantPacer->Start();
+
+  return true;
+}
+
+void EpisodeRunner::Pipeline()
+{
+  Profiler::NameThread("pipeline");
+  std::unique_lock<std::mutex> lock(pipeLock);
+
+  while (true) {
+    pipeReady.wait(lock, [this] { return busy || stop; });
+    if (stop)
+      break;
+    lock.unlock();
+
+    {
+      PROFILE_SCOPE("readout");
+      job.policy = agent->GetAction(job.t);
+      job.dopa = agent->GetDopa(job.t);
+      double *v = agent->GetValue(job.t, job.reward);
+      job.value = v[0];
+      job.tdError = job.zeroTd ? 0 : v[1];
+    }
+
+    if (job.sendState) {
+      PROFILE_SCOPE("send state");
+      agent->SendState(job.state, job.t);
+    }
+    {
+      PROFILE_SCOPE("send reward");
+      agent->SendReward(std::max(-1000.0, std::min(1000.0, job.tdError)), job.t);
+    }
+
+    lock.lock();
+    busy = false;
+    pipeDone.notify_one();
+  }
+}
+
+void EpisodeRunner::Post()
+{
+  std::lock_guard<std::mutex> guard(pipeLock);
+  busy = true;
+  pipeReady.notify_one();
+}
+
+void EpisodeRunner::Idle()
+{
+  std::unique_lock<std::mutex> lock(pipeLock);
+  pipeDone.wait(lock, [this] { return !busy; });
+}
+
+void EpisodeRunner::Collect()
+{
+  Idle();
+
+  policy = job.policy;
+  dopaActivity = job.dopa;
+  valueFunction = job.value;
+  tdError = job.tdError;
+}
+
+void EpisodeRunner::StopWorker()
+{
+  if (!worker.joinable())
+    return;
+
+  Idle();
+  {
+    std::lock_guard<std::mutex> guard(pipeLock);
+    stop = true;
+    pipeReady.notify_one();
+  }
+  worker.join();
+}
@@ -0,0 +1,59 @@
+/*
+ *  agent.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AGENT_H
+#define AGENT_H
+
+#include <iostream>
+#include <armadillo>
+
+// Neural controller seen from the environment side. Once per neural tick the
+// environment sends state and reward, advances the agent and reads back the
+// decoded populations.
+class Agent
+{
+public:
+  virtual ~Agent() {}
+
+  // Agent time at the start of the runtime phase
+  virtual double Time() = 0;
+
+  // Encode state and reward for the current tick
+  virtual void SendState(arma::vec& q, double tickt) = 0;
+  virtual void SendReward(double reward, double tickt) = 0;
+
+  // Advance the agent by one tick and return the new agent time
+  virtual double Tick() = 0;
+
+  // Decode the readout populations
+  virtual double GetAction(double tickt) = 0;
+  virtual double GetDopa(double tickt) = 0;
+  virtual double* GetValue(double tickt, double reward) = 0; // [value, tdError]
+
+  // End of the runtime phase
+  virtual void Finalize() {}
+
+  // Checkpoint; agents whose state lives elsewhere keep these empty
+  virtual void Save(std::ostream& out) {}
+  virtual void Load(std::istream& in) {}
+};
+
+#endif // AGENT_H
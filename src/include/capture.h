@@ -0,0 +1,78 @@
+/*
+ *  capture.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Video capture decoupled from rendering: frames (RGB, bottom-up rows as read
+// from OpenGL) are copied into a fixed pool of buffers and queued to an
+// encoder thread piping them to ffmpeg. When every buffer is in use the frame
+// is dropped, the render loop never waits for the encoder.
+class FrameCapture
+{
+public:
+  // buffers -> frames in the pool (bounds memory and queue length)
+  FrameCapture(const std::string& video, int width, int height, double fps, int buffers = 8);
+
+  virtual ~FrameCapture();
+
+  // Free buffer of Width()*Height()*3 bytes, NULL when the pool is exhausted
+  unsigned char* Acquire();
+
+  // Queue a filled buffer for encoding
+  void Submit(unsigned char *frame);
+
+  // Encode the queued frames and close the video
+  void Close();
+
+  inline int Buffers() { return pool.size(); };
+  inline int Width() { return width; };
+  inline int Height() { return height; };
+  inline long Captured() { return captured; };
+  inline long Dropped() { return dropped; };
+  inline long Encoded() { return encoded; };
+
+protected:
+  void Encode();
+
+private:
+  int width, height;
+  std::vector < std::vector<unsigned char> > pool;
+  std::deque<int> free, queue;
+
+  FILE *encoder;
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable ready;
+  bool done;
+
+  long captured, dropped, encoded;
+};
+
+#endif // CAPTURE_H
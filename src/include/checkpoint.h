@@ -0,0 +1,150 @@
+/*
+ *  checkpoint.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <stdint.h>
+#include <armadillo>
+
+// Binary snapshot primitives. Every stateful class writes its state with
+// Save(std::ostream&) and reads it back, in the same order, with
+// Load(std::istream&). Values are stored raw (host byte order).
+
+template<class T> inline void Put(std::ostream& out, const T& value)
+{
+  out.write((const char*)&value, sizeof(T));
+}
+
+template<class T> inline void Get(std::istream& in, T& value)
+{
+  in.read((char*)&value, sizeof(T));
+}
+
+// Whether count items of size bytes are left in the stream; fails the stream
+// otherwise, so a mismatched layout never allocates a garbage size
+inline bool Fits(std::istream& in, uint64_t count, uint64_t size)
+{
+  if (!in)
+    return false;
+
+  std::streampos pos = in.tellg();
+  in.seekg(0, std::ios::end);
+  uint64_t left = in.tellg() - pos;
+  in.seekg(pos);
+
+  if (count > left/size) {
+    in.setstate(std::ios::failbit);
+    return false;
+  }
+  return true;
+}
+
+template<class T> inline void Put(std::ostream& out, const std::vector<T>& v)
+{
+  Put(out, (uint64_t)v.size());
+  out.write((const char*)v.data(), v.size()*sizeof(T));
+}
+
+template<class T> inline void Get(std::istream& in, std::vector<T>& v)
+{
+  uint64_t n = 0;
+  Get(in, n);
+  if (!Fits(in, n, sizeof(T)))
+    return;
+  v.resize(n);
+  in.read((char*)v.data(), n*sizeof(T));
+}
+
+template<class T> inline void Put(std::ostream& out, const std::vector< std::vector<T> >& v)
+{
+  Put(out, (uint64_t)v.size());
+  for (size_t i = 0; i < v.size(); ++i)
+    Put(out, v[i]);
+}
+
+template<class T> inline void Get(std::istream& in, std::vector< std::vector<T> >& v)
+{
+  uint64_t n = 0;
+  Get(in, n);
+  if (!Fits(in, n, sizeof(uint64_t)))
+    return;
+  v.resize(n);
+  for (size_t i = 0; i < n && in; ++i)
+    Get(in, v[i]);
+}
+
+inline void Put(std::ostream& out, const std::string& s)
+{
+  Put(out, (uint64_t)s.size());
+  out.write(s.data(), s.size());
+}
+
+inline void Get(std::istream& in, std::string& s)
+{
+  uint64_t n = 0;
+  Get(in, n);
+  if (!Fits(in, n, 1))
+    return;
+  s.resize(n);
+  in.read(&s[0], n);
+}
+
+// Armadillo objects (vectors keep their type on GetMat)
+inline void PutMat(std::ostream& out, const arma::mat& m)
+{
+  Put(out, (uint64_t)m.n_rows);
+  Put(out, (uint64_t)m.n_cols);
+  out.write((const char*)m.memptr(), m.n_elem*sizeof(double));
+}
+
+template<class M> inline void GetMat(std::istream& in, M& m)
+{
+  uint64_t rows = 0, cols = 0;
+  Get(in, rows);
+  Get(in, cols);
+  if (!Fits(in, rows, sizeof(double)) || (rows > 0 && !Fits(in, cols, rows*sizeof(double))))
+    return;
+  m.set_size(rows, cols);
+  in.read((char*)m.memptr(), m.n_elem*sizeof(double));
+}
+
+// Random engines through their textual state (boost/std streaming)
+template<class Engine> inline void PutEngine(std::ostream& out, const Engine& engine)
+{
+  std::ostringstream state;
+  state << engine;
+  Put(out, state.str());
+}
+
+template<class Engine> inline void GetEngine(std::istream& in, Engine& engine)
+{
+  std::string text;
+  Get(in, text);
+  std::istringstream state(text);
+  state >> engine;
+}
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,127 @@
+/*
+ *  columnfile.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COLUMNFILE_H
+#define COLUMNFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <armadillo>
+
+// Binary columnar data file (.bin)
+//
+//   header   magic "RBCOLS1", dtype, columns, blockSize, rate [Hz],
+//            length [samples], data offset, column names ('\0' separated)
+//   data     blocks of blockSize samples, each block stores its columns one
+//            after the other (the last block may be shorter)
+//
+// A file with a single block is fully columnar and is read without copies.
+enum ColumnType { FLOAT64 = 0 };
+
+struct ColumnHeader
+{
+  char magic[8];
+  uint32_t dtype, columns, blockSize, reserved;
+  double rate;
+  uint64_t length, offset;
+};
+
+// Appends blocks of samples; the length in the header is fixed on Close
+class ColumnWriter
+{
+public:
+  // names -> column names separated by spaces (empty -> name0, name1, ...)
+  ColumnWriter(const std::string& path, int columns, int blockSize, double rate = 0, const std::string& names = "");
+
+  virtual ~ColumnWriter();
+
+  // Write one block of samples stored sample by sample (samples <= blockSize)
+  void WriteBlock(const double *data, int samples);
+
+  void Close();
+
+  // Whole matrix (samples x columns) as a single block
+  static bool Save(const arma::mat& data, const std::string& path, double rate = 0, const std::string& names = "");
+
+  // Rewrite a closed file of several blocks as a single block, column by
+  // column from the mapped file
+  static bool Compact(const std::string& path);
+
+private:
+  FILE *file;
+  ColumnHeader header;
+  std::vector<double> buffer;
+};
+
+// Memory mapped reader
+class ColumnReader
+{
+public:
+  ColumnReader(const std::string& path);
+
+  virtual ~ColumnReader();
+
+  inline bool IsOpen() { return base != NULL; };
+  inline int Columns() { return header->columns; };
+  inline long Length() { return header->length; };
+  inline double Rate() { return header->rate; };
+  inline const std::string& Name(int col) { return names[col]; };
+
+  // Column index from its name, -1 if missing
+  int Index(const std::string& name);
+
+  // Column col, a view on the mapped file when stored in a single block
+  arma::vec Column(int col);
+
+  // Samples x columns (column major) in the mapped file when stored in a
+  // single block, NULL otherwise
+  inline const double* Data() {
+    return header->length <= header->blockSize ? (const double*)(base + header->offset) : NULL;
+  };
+
+  // Whole file as samples x columns
+  void Load(arma::mat& data);
+
+  // Save as text, one sample per line (one channel per line with
+  // channelRows, the layout of recordings made before the binary files)
+  bool SaveText(const std::string& path, bool channelRows = false);
+
+private:
+  friend class ColumnWriter;
+
+  const double* Block(int block, int col, long *samples);
+
+  int fd;
+  size_t size;
+  char *base;
+  const ColumnHeader *header;
+  std::vector<std::string> names;
+};
+
+// Load name.bin when present, name.dat (raw ascii, one sample per line) otherwise.
+// With channels > 0, a .dat holding channels rows is an old recording (one
+// channel per line) and is transposed.
+bool LoadColumns(arma::mat& data, const std::string& name, int channels = 0);
+
+#endif // COLUMNFILE_H
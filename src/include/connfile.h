@@ -0,0 +1,122 @@
+/*
+ *  connfile.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef CONNFILE_H
+#define CONNFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+#include <armadillo>
+
+// Binary connectivity file of the BeeBrain network (.bin), the text files
+// (source target w_start w_end per line) in compact form
+//
+//   header   magic "RBCONN1", weight type, record size [bytes], synapses
+//   data     one record per synapse: source, target (int32), start and
+//            end weight (float32 or float64)
+enum ConnWeight { CONN_FLOAT32 = 4, CONN_FLOAT64 = 8 };
+
+struct ConnHeader
+{
+  char magic[8];
+  uint32_t weight, record;
+  uint64_t count;
+};
+
+// Weights as a sparse matrix in CSR form: row r holds the synapses of
+// source firstRow + r, cols are target ids
+struct CsrMatrix
+{
+  int firstRow, rows;
+  std::vector<int> rowPtr, cols;
+  std::vector<double> values;
+};
+
+// Appends synapses; the count in the header is fixed on Close
+class ConnWriter
+{
+public:
+  ConnWriter(const std::string& path, ConnWeight weight = CONN_FLOAT64);
+
+  virtual ~ConnWriter();
+
+  inline bool IsOpen() { return file != NULL; };
+
+  void Append(int source, int target, double wStart, double wEnd);
+
+  void Close();
+
+private:
+  void Write();
+
+  FILE *file;
+  ConnHeader header;
+  std::vector<char> buffer;
+  size_t used;
+};
+
+// Memory mapped reader
+class ConnReader
+{
+public:
+  ConnReader(const std::string& path);
+
+  virtual ~ConnReader();
+
+  inline bool IsOpen() { return base != NULL; };
+  inline long Count() { return header->count; };
+
+  inline int Source(long i) { return ((const int32_t*)Record(i))[0]; };
+  inline int Target(long i) { return ((const int32_t*)Record(i))[1]; };
+
+  // Start (end = false) or end weight of synapse i
+  inline double Weight(long i, bool end) {
+    const char *w = Record(i) + 2*sizeof(int32_t) + (end ? header->weight : 0);
+    return header->weight == CONN_FLOAT32 ? *(const float*)w : *(const double*)w;
+  };
+
+  // Whole file as synapses x [source target w_start w_end], the text layout
+  void Load(arma::mat& data);
+
+  // Start or end weights as CSR, synapses of a row in file order
+  void Csr(CsrMatrix& matrix, bool end);
+
+  bool SaveText(const std::string& path);
+
+private:
+  inline const char* Record(long i) { return base + sizeof(ConnHeader) + i*header->record; };
+
+  int fd;
+  size_t size;
+  char *base;
+  const ConnHeader *header;
+};
+
+// Streaming text -> binary conversion, returns the synapses written or -1
+long ConvertConnections(const std::string& text, const std::string& path, ConnWeight weight = CONN_FLOAT64);
+
+// Load name.bin when present, name.dat otherwise
+bool LoadConnections(arma::mat& data, const std::string& name);
+
+#endif // CONNFILE_H
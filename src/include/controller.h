@@ -25,41 +25,56 @@
 #include <cmath>
 #include <vector>
 #include <armadillo>
+#include "include/filter.h"
+#include "include/checkpoint.h"
 
 class Controller
 {
 public:
-	// Constructor
-	Controller(arma::vec& q_desired);
+	// Constructor (frequency -> control loop rate used to discretize the designs)
+	Controller(arma::vec& q_desired, double frequency);
 
 	// Destructor
 	~Controller();
 
-	// Altitude Controller
-	arma::vec AltitudeControl(arma::vec& q);
+	// Redesign the altitude compensator from a continuous transfer function
+	// num(s)/den(s) (3 coefficients each, descending powers of s)
+	void SetAltitude(const double *num, const double *den, Discretization method);
 
-	// Damping Controller (Attitude)
-	arma::vec DampingControl(arma::vec& q);
+	// Attitude damping gains [k (theta), kd (omega)]
+	void SetDamping(const double *k);
+
+	// Altitude Controller (lift force -> f_l[0], holds the previous output)
+	void AltitudeControl(const arma::vec& q, double *f_l);
+
+	// Damping Controller (Attitude) (torques -> tau_c[0..2])
+	void DampingControl(const arma::vec& q, double *tau_c);
+
+	// Full control step: u[0] lift force, u[1..3] torques
+	inline void Control(const arma::vec& q, double *u) { AltitudeControl(q, u); DampingControl(q, u+1); };
 
 	inline void Reset() { init = 0; };
 
+	// Checkpoint (filter state)
+	void Save(std::ostream& out);
+	void Load(std::istream& in);
+
 protected:
 
 private:
 
 	int init;
 
-	double g, m, T,
-		     *fl_e, // e, ed, ei
-		   	 *fl_k, // k, kd, ki
-		   	 *tauc_k,
-		     prev_q, dt,
+	double g, m, dt,
+		     fl_e[2], // e, ed
+		   	 tauc_k[2], // k (theta), kd (omega)
 		     max_f_l,
 		     max_torque;
 
-	arma::mat A, B, C, D;
+	StateSpace<2> altitude;           // Altitude compensator
+	StateSpace<0, 2, 1> damping[3];   // Per axis attitude gains [theta, omega]
 
-	arma::vec q_d, x, f_l, omega, tau_c, tauc_e;
+	arma::vec q_d;
 };
 
 #endif
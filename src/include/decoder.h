@@ -44,6 +44,8 @@ public:
 	
 	double NLKernelDev(double tickt, std::vector <double> *spikes);
 
+	inline double Window() { return delta_t; };
+
 private:
 	double delta_t,
 		   counter = 0,
@@ -22,7 +22,8 @@
 #ifndef ENCODER_H
 #define ENCODER_H
 
-#include <music.hh>
+#include "include/eventport.h"
+#include "include/checkpoint.h"
 #include <boost/random.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <math.h>
@@ -47,7 +48,11 @@ public:
   Encoder ();
   virtual ~Encoder ();
 
-  void PoissonSpikeGenerator(MUSIC::EventOutputPort* outport, double rate, double tickt, int index);
+  void PoissonSpikeGenerator(EventOutput* outport, double rate, double tickt, int index);
+
+  // Checkpoint (generator state)
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
 
 private:
   double winLength, t;
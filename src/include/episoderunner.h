@@ -0,0 +1,204 @@
+/*
+ *  episoderunner.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EPISODERUNNER_H
+#define EPISODERUNNER_H
+
+#include <cmath>
+#include <string>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <armadillo>
+#include "include/robobee.h"
+#include "include/controller.h"
+#include "include/agent.h"
+#include "include/iomanager.h"
+#include "include/recorder.h"
+#include "include/telemetry.h"
+#include "include/checkpoint.h"
+#include "include/profiler.h"
+#include "include/pacer.h"
+
+// Closed loop between the RoboBee plant, the classical controller and a neural
+// agent: reward, crash detection, trial resets, controlRate adaptation and
+// recording. Needs neither MUSIC nor OpenGL.
+class EpisodeRunner
+{
+public:
+  EpisodeRunner(arma::vec& q0, arma::vec& q_desired, double dynFreq, double TICK);
+
+  virtual ~EpisodeRunner();
+
+  // Reward shaping: maxRew/2*cos(theta) + maxRew*exp(-omega^2/(2*sigma^2)) - maxRew/2
+  void SetReward(double maxRew, double sigma);
+
+  // Crash limits on theta and omega
+  void SetBounds(double thetaBound, double omegaBound);
+
+  // Trial log (NULL -> no log)
+  void SetLog(Iomanager *manager);
+
+  // Recorded channels: simtime, state, control, network (at the TICK rate),
+  // environment (NULL -> no recording)
+  void SetRecorder(Recorder *recorder);
+  void SetNetControl(bool netControl);
+
+  // Live samples for external monitors, every step (NULL -> off)
+  void SetTelemetry(Telemetry *telemetry);
+
+  // Real-time mode: plant steps paced at dynFreq against the wall clock,
+  // neural ticks accounted against TICK (NULL -> as fast as possible)
+  void SetPacing(Pacer *plant, Pacer *neural);
+
+  // Readout of tick k and encoding for tick k+1 on a worker thread, overlapped
+  // with the plant steps up to tick k+1: the policy is applied one TICK later
+  void SetPipelined(bool pipelined);
+
+  // Start the runtime phase against agent for simt seconds
+  void Start(Agent *agent, double simt);
+
+  // Snapshot to path every interval seconds of simulated time (0 -> off)
+  void SetCheckpoint(const std::string& path, double interval);
+
+  // Plant, controller, trial bookkeeping and agent state; Restore after Start
+  bool Checkpoint(const std::string& path);
+  bool Restore(const std::string& path);
+
+  // Advance the plant by one dynamics step (neural tick included when due),
+  // then wait for the step deadline in real-time mode
+  void Step();
+
+  // Step split around the agent tick, for runners sharing one time base
+  // (Swarm): Prepare runs the controller and the encoding and tells whether
+  // a neural tick is due, Complete ticks the agent and advances the plant
+  bool Prepare();
+  void Complete(bool tick);
+
+  // Step until simt, then finalize the agent
+  void Run();
+
+  inline bool Running() { return tickt < simt; };
+
+  void Finalize();
+
+  inline arma::vec& State() { return q; };
+  inline Controller& GetController() { return ctr; };
+  inline double Time() { return dynTime; };
+  inline double ControlRate() { return controlRate; };
+  inline int Trials() { return trials; };
+  inline double SuccTrials() { return succTrial; };
+
+protected:
+  // Pipelined readout/encoding
+  void Pipeline();          // Worker loop
+  void Post();              // Hand job to the worker
+  void Idle();              // Wait for the worker to be done
+  void Collect();           // Idle and apply the readout
+  void StopWorker();
+  void PrintTrial();
+  // Snapshot body; LoadState is false when the layout does not match
+  void SaveState(std::ostream& out);
+  bool LoadState(std::istream& in, uint64_t length);
+  inline double Reward() {
+    return maxRew/2*cos(q(0)) + maxRew*std::exp(-std::pow(q(3),2)/(2*std::pow(sigma,2))) - maxRew/2;
+  };
+
+private:
+  Robobee bee;
+  Controller ctr;
+  Agent *agent;
+  Iomanager *manager;
+  Recorder *recorder;
+  Telemetry *telemetry;
+  Pacer *plantPacer, *neuralPacer;
+
+  arma::vec q, q0, q_d, u,
+            tickState,  // State at the last neural tick
+            crashState;
+
+  double dynStep, TICK, simt,
+         maxRew, sigma,
+         reward,
+         tickRew,           // Reward at the last neural tick
+         *value,
+         valueFunction,
+         tdError,
+         policy,
+         dopaActivity;
+
+  int iter,
+      trials;
+
+  double tickt,             // Neuro-Controller/MUSIC TICK time
+         dynTime,           // Simulation time
+         loadDopa,          // Dopaminergic neurons loading time
+         startSim,          // Simulation start time
+         punishTime,        // Time of punish deliverying
+         clockStop,         // Resting time between trials
+         trialTime,         // Record duration of each trial
+         prevRew,
+         robotPos,
+         thetaCheck,
+         omegaCheck,
+         cageBound,
+         thetaBound,
+         omegaBound,
+         controlRate,
+         cumulativeRew,
+         succTrial;
+
+  bool netControl;
+
+  // Checkpoint
+  std::string checkpointPath;
+  double checkpointInterval,
+         nextCheckpoint,
+         agentOffset;       // Runner time - agent time (non zero after a restore)
+
+  // Pipelined mode, job is owned by the worker while busy
+  struct PipeJob
+  {
+    double t, reward;
+    arma::vec state;
+    bool sendState, zeroTd;
+    double policy, dopa, value, tdError;   // Readout
+  };
+
+  bool pipelined,
+       primed;              // Encoding for the next tick already done
+  PipeJob job;
+  std::thread worker;
+  std::mutex pipeLock;
+  std::condition_variable pipeReady, pipeDone;
+  bool busy, stop;
+
+  // Recorder channels
+  int recTime, recState, recControl, recNetwork, recEnvironment;
+};
+
+#endif // EPISODERUNNER_H
@@ -0,0 +1,116 @@
+/*
+ *  eventport.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EVENTPORT_H
+#define EVENTPORT_H
+
+#include <vector>
+
+// Destination of the spike events produced on the environment side
+class EventOutput
+{
+public:
+  virtual ~EventOutput() {}
+
+  // Spike on channel id at time t [s]
+  virtual void InsertEvent(double t, int id) = 0;
+};
+
+// Handler of the spike events coming back from the network
+class EventInput
+{
+public:
+  virtual ~EventInput() {}
+
+  // Spike on channel id at time t [s]
+  virtual void HandleEvent(double t, int id) = 0;
+};
+
+// Counts the events passing through to port
+class EventCounter : public EventOutput
+{
+public:
+  EventCounter(EventOutput *_port) : port(_port), count(0) {}
+
+  inline void InsertEvent(double t, int id) { ++count; port->InsertEvent(t, id); }
+
+  // Events since the last call
+  inline long Take() { long n = count; count = 0; return n; }
+
+private:
+  EventOutput *port;
+  long count;
+};
+
+// Destination of rate coded channels: the receiving side draws the spikes
+class RateOutput
+{
+public:
+  virtual ~RateOutput() {}
+
+  // Firing rate [Hz] of channel id from now until it is set again
+  virtual void SetRate(int id, double rate) = 0;
+};
+
+// Block of channels starting at offset of a shared output (one bee of a swarm)
+class EventOffset : public EventOutput
+{
+public:
+  EventOffset(EventOutput *_port, int _offset) : port(_port), offset(_offset) {}
+
+  inline void InsertEvent(double t, int id) { port->InsertEvent(t, id + offset); }
+
+private:
+  EventOutput *port;
+  int offset;
+};
+
+class RateOffset : public RateOutput
+{
+public:
+  RateOffset(RateOutput *_port, int _offset) : port(_port), offset(_offset) {}
+
+  inline void SetRate(int id, double rate) { port->SetRate(id + offset, rate); }
+
+private:
+  RateOutput *port;
+  int offset;
+};
+
+// Splits channels first, first+1, ... into blocks of width channels, block k
+// goes to the k-th added input renumbered from 0
+class EventDemux : public EventInput
+{
+public:
+  EventDemux(int _first, int _width) : first(_first), width(_width) {}
+
+  inline void Add(EventInput *input) { inputs.push_back(input); }
+
+  inline void HandleEvent(double t, int id) {
+    inputs[(id - first)/width]->HandleEvent(t, (id - first) % width);
+  }
+
+private:
+  int first, width;
+  std::vector<EventInput*> inputs;
+};
+
+#endif // EVENTPORT_H
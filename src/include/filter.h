@@ -0,0 +1,319 @@
+/*
+ *  filter.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <cmath>
+#include <algorithm>
+
+// Discrete linear filters with compile-time dimensions. All the storage is
+// inline in the object, so stepping a filter never touches the heap.
+
+// Continuous -> discrete transformations
+enum Discretization { TUSTIN, ZOH };
+
+// State-space realization with N states, M inputs and P outputs
+//   y[k]   = C*x[k] + D*u[k]
+//   x[k+1] = A*x[k] + B*u[k]
+template <int N, int M = 1, int P = 1>
+class StateSpace
+{
+public:
+	StateSpace() { Clear(); }
+
+	// Zero matrices and state
+	void Clear()
+	{
+		for (int i = 0; i < N; ++i) {
+			for (int j = 0; j < N; ++j) A[i][j] = 0;
+			for (int j = 0; j < M; ++j) B[i][j] = 0;
+		}
+		for (int i = 0; i < P; ++i) {
+			for (int j = 0; j < N; ++j) C[i][j] = 0;
+			for (int j = 0; j < M; ++j) D[i][j] = 0;
+		}
+		Reset();
+	}
+
+	// Zero the state only
+	inline void Reset() { for (int i = 0; i < N; ++i) x[i] = 0; }
+
+	// Write y[k] into y (P values) and advance the state with u[k] (M values)
+	inline void Step(const double *u, double *y)
+	{
+		double xn[N];
+
+		for (int i = 0; i < P; ++i) {
+			y[i] = 0;
+			for (int j = 0; j < N; ++j) y[i] += C[i][j]*x[j];
+			for (int j = 0; j < M; ++j) y[i] += D[i][j]*u[j];
+		}
+
+		for (int i = 0; i < N; ++i) {
+			xn[i] = 0;
+			for (int j = 0; j < N; ++j) xn[i] += A[i][j]*x[j];
+			for (int j = 0; j < M; ++j) xn[i] += B[i][j]*u[j];
+		}
+
+		for (int i = 0; i < N; ++i) x[i] = xn[i];
+	}
+
+	// Discretize the continuous transfer function num(s)/den(s) with sample time T.
+	// num and den hold N+1 coefficients in descending powers of s (den[0] != 0).
+	// Only meaningful for single input/output realizations.
+	void Discretize(const double *num, const double *den, double T, Discretization method)
+	{
+		double Ac[N][N], Bc[N], Cc[N], Dc, I[N][N], M1[N][N], M2[N][N];
+
+		// Continuous observable canonical form
+		Dc = num[0]/den[0];
+		for (int i = 0; i < N; ++i) {
+			for (int j = 0; j < N; ++j)
+				Ac[i][j] = (j == i+1) ? 1 : 0;
+			Ac[i][0] = -den[i+1]/den[0];
+			Bc[i] = num[i+1]/den[0] - Dc*den[i+1]/den[0];
+			Cc[i] = (i == 0) ? 1 : 0;
+		}
+
+		Clear();
+
+		if (method == TUSTIN) {
+			// A = (I - Ac*T/2)^-1 (I + Ac*T/2), B = (I - Ac*T/2)^-1 Bc*T
+			// C = Cc (I - Ac*T/2)^-1,           D = Dc + C*Bc*T/2
+			for (int i = 0; i < N; ++i)
+				for (int j = 0; j < N; ++j) {
+					I[i][j] = (i == j) ? 1 : 0;
+					M1[i][j] = I[i][j] - Ac[i][j]*T/2;
+					M2[i][j] = I[i][j] + Ac[i][j]*T/2;
+				}
+			Invert(M1);
+
+			for (int i = 0; i < N; ++i) {
+				for (int j = 0; j < N; ++j)
+					for (int k = 0; k < N; ++k)
+						A[i][j] += M1[i][k]*M2[k][j];
+				for (int k = 0; k < N; ++k) {
+					B[i][0] += M1[i][k]*Bc[k]*T;
+					C[0][i] += Cc[k]*M1[k][i];
+				}
+			}
+			D[0][0] = Dc;
+			for (int i = 0; i < N; ++i)
+				D[0][0] += C[0][i]*Bc[i]*T/2;
+		}
+		else {
+			// exp([Ac Bc; 0 0]*T) = [A B; 0 1]
+			double E[N+1][N+1];
+			for (int i = 0; i <= N; ++i)
+				for (int j = 0; j <= N; ++j)
+					E[i][j] = (i < N) ? ((j < N) ? Ac[i][j]*T : Bc[i]*T) : 0;
+			Expm(E);
+
+			for (int i = 0; i < N; ++i) {
+				for (int j = 0; j < N; ++j)
+					A[i][j] = E[i][j];
+				B[i][0] = E[i][N];
+				C[0][i] = Cc[i];
+			}
+			D[0][0] = Dc;
+		}
+	}
+
+	double A[N][N], B[N][M], C[P][N], D[P][M], x[N];
+
+private:
+	// In place Gauss-Jordan inversion with partial pivoting
+	static void Invert(double (&X)[N][N])
+	{
+		double R[N][N], tmp;
+		int piv;
+
+		for (int i = 0; i < N; ++i)
+			for (int j = 0; j < N; ++j)
+				R[i][j] = (i == j) ? 1 : 0;
+
+		for (int c = 0; c < N; ++c) {
+			piv = c;
+			for (int r = c+1; r < N; ++r)
+				if (std::abs(X[r][c]) > std::abs(X[piv][c]))
+					piv = r;
+			for (int j = 0; j < N; ++j) {
+				tmp = X[c][j]; X[c][j] = X[piv][j]; X[piv][j] = tmp;
+				tmp = R[c][j]; R[c][j] = R[piv][j]; R[piv][j] = tmp;
+			}
+			tmp = X[c][c];
+			for (int j = 0; j < N; ++j) {
+				X[c][j] /= tmp;
+				R[c][j] /= tmp;
+			}
+			for (int r = 0; r < N; ++r) {
+				if (r == c)
+					continue;
+				tmp = X[r][c];
+				for (int j = 0; j < N; ++j) {
+					X[r][j] -= tmp*X[c][j];
+					R[r][j] -= tmp*R[c][j];
+				}
+			}
+		}
+
+		for (int i = 0; i < N; ++i)
+			for (int j = 0; j < N; ++j)
+				X[i][j] = R[i][j];
+	}
+
+	// In place matrix exponential (scaling and squaring of a Taylor series)
+	static void Expm(double (&X)[N+1][N+1])
+	{
+		const int K = N+1;
+		double S[K][K], T[K][K], R[K][K], norm = 0, row;
+		int squarings = 0;
+
+		for (int i = 0; i < K; ++i) {
+			row = 0;
+			for (int j = 0; j < K; ++j)
+				row += std::abs(X[i][j]);
+			norm = std::max(norm, row);
+		}
+		while (norm > 0.5) {
+			norm /= 2;
+			squarings++;
+		}
+
+		for (int i = 0; i < K; ++i)
+			for (int j = 0; j < K; ++j) {
+				X[i][j] = std::ldexp(X[i][j], -squarings);
+				S[i][j] = (i == j) ? 1 : 0;
+				T[i][j] = S[i][j];
+			}
+
+		// S = sum X^n/n!
+		for (int n = 1; n <= 16; ++n) {
+			for (int i = 0; i < K; ++i)
+				for (int j = 0; j < K; ++j) {
+					R[i][j] = 0;
+					for (int k = 0; k < K; ++k)
+						R[i][j] += T[i][k]*X[k][j];
+				}
+			for (int i = 0; i < K; ++i)
+				for (int j = 0; j < K; ++j) {
+					T[i][j] = R[i][j]/n;
+					S[i][j] += T[i][j];
+				}
+		}
+
+		for (int s = 0; s < squarings; ++s) {
+			for (int i = 0; i < K; ++i)
+				for (int j = 0; j < K; ++j) {
+					R[i][j] = 0;
+					for (int k = 0; k < K; ++k)
+						R[i][j] += S[i][k]*S[k][j];
+				}
+			for (int i = 0; i < K; ++i)
+				for (int j = 0; j < K; ++j)
+					S[i][j] = R[i][j];
+		}
+
+		for (int i = 0; i < K; ++i)
+			for (int j = 0; j < K; ++j)
+				X[i][j] = S[i][j];
+	}
+};
+
+// Static gain (no states): y = D*u
+template <int M, int P>
+class StateSpace<0, M, P>
+{
+public:
+	StateSpace() { Clear(); }
+
+	void Clear()
+	{
+		for (int i = 0; i < P; ++i)
+			for (int j = 0; j < M; ++j) D[i][j] = 0;
+	}
+
+	inline void Reset() {}
+
+	// A gain is the same in continuous and discrete time
+	void Discretize(const double *num, const double *den, double T, Discretization method)
+	{
+		Clear();
+		D[0][0] = num[0]/den[0];
+	}
+
+	inline void Step(const double *u, double *y)
+	{
+		for (int i = 0; i < P; ++i) {
+			y[i] = 0;
+			for (int j = 0; j < M; ++j) y[i] += D[i][j]*u[j];
+		}
+	}
+
+	double D[P][M];
+};
+
+// Cascade of S second-order sections in transposed direct form II
+//   H_s(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+template <int S>
+class BiquadCascade
+{
+public:
+	BiquadCascade() { Clear(); }
+
+	// Every section becomes a unit pass-through
+	void Clear()
+	{
+		for (int i = 0; i < S; ++i) {
+			b[i][0] = 1; b[i][1] = 0; b[i][2] = 0;
+			a[i][0] = 0; a[i][1] = 0;
+		}
+		Reset();
+	}
+
+	inline void Reset() { for (int i = 0; i < S; ++i) z[i][0] = z[i][1] = 0; }
+
+	// Set section s: a1, a2 are the normalized denominator coefficients
+	void SetSection(int s, double b0, double b1, double b2, double a1, double a2)
+	{
+		b[s][0] = b0; b[s][1] = b1; b[s][2] = b2;
+		a[s][0] = a1; a[s][1] = a2;
+	}
+
+	inline double Step(double u)
+	{
+		double y;
+
+		for (int i = 0; i < S; ++i) {
+			y = b[i][0]*u + z[i][0];
+			z[i][0] = b[i][1]*u - a[i][0]*y + z[i][1];
+			z[i][1] = b[i][2]*u - a[i][1]*y;
+			u = y;
+		}
+
+		return u;
+	}
+
+	double b[S][3], a[S][2], z[S][2];
+};
+
+#endif // FILTER_H
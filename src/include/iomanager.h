@@ -26,6 +26,50 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <cstddef>
+#include <stdint.h>
+#include "include/logwriter.h"
+
+// Vector files: text (one value per line) or binary, magic "RBVEC1",
+// count (uint64_t) and the values (float64)
+enum VecFormat { TEXT_VEC, BINARY_VEC };
+
+struct VecHeader
+{
+	char magic[8];
+	uint64_t count;
+};
+
+// Vector file seen in place: a binary file is memory mapped (no copy), a
+// text file is parsed once into memory
+class VecView
+{
+public:
+	VecView(const std::string& path);
+
+	virtual ~VecView();
+
+	inline bool IsOpen() { return opened; };
+	inline size_t Size() const { return count; };
+	inline const double* Data() const { return data; };
+	inline const double* begin() const { return data; };
+	inline const double* end() const { return data + count; };
+	inline double operator[](size_t i) const { return data[i]; };
+
+private:
+	VecView(const VecView&);
+	VecView& operator=(const VecView&);
+
+	bool opened;
+	int fd;
+	size_t size, count;
+	char *base;
+	const double *data;
+	std::vector<double> parsed;  // Text file
+};
 
 class Iomanager
 {
@@ -39,25 +83,47 @@ public:
 	// Destroyer
 	~Iomanager();
 
+	// stype: "in" -> Read, "out" -> Print (text log), "bin" -> Record (binary log)
 	void SetStream(const std::string& fname, const std::string& stype);
 
 	std::ifstream& Read();
-	std::ofstream& Print();
+
+	// Buffered log, safe from any thread: each thread has its own stream and
+	// a line reaches the background writer at std::endl (no disk flush)
+	std::ostream& Print();
+
+	// One framed record in the binary log
+	void Record(const void *data, size_t size);
+
+	// Logs on disk
+	void Flush();
 
 	// Save Data in a file
-	void SaveVec(const std::string& fname, std::vector<double> *vect);
+	void SaveVec(const std::string& fname, std::vector<double> *vect, VecFormat format = TEXT_VEC);
 
-	// Load Data from a file
+	// Load Data from a file (either format)
 	std::vector<double> LoadVec(const std::string& fname);
 
+	// View on a file (either format) without copying a binary one, owned by the caller
+	VecView* MapVec(const std::string& fname);
+
+	// Copy of fname (in loadDir) to path: a copy-on-write clone where the
+	// filesystem supports it, an in-kernel copy otherwise. Not a hard link,
+	// the source is rewritten in place by the next run
+	bool Clone(const std::string& fname, const std::string& path);
+
 protected:
 
 private:
 	std::string loadDir;
 	std::string saveDir;
 
-	std::ofstream outStream;
 	std::ifstream inStream;
+
+	// Logs
+	LogWriter *textLog, *binLog;
+	std::map<std::thread::id, std::ostream*> streams;
+	std::mutex streamLock;
 };
 
 #endif
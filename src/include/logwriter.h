@@ -0,0 +1,104 @@
+/*
+ *  logwriter.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <string>
+#include <deque>
+#include <fstream>
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+enum LogFormat { TEXT_LOG, BINARY_LOG };
+
+// Log file written by a background thread. Records are copied into blocks
+// of blockSize bytes; full blocks are queued to the writer, which also
+// writes the partial block and flushes the file every period seconds.
+// Write never waits for the disk: with maxBlocks blocks already queued the
+// record is dropped (and counted). Thread-safe.
+// TEXT_LOG keeps records as they are, BINARY_LOG frames each one with its
+// size (uint32_t) so that it can be read back record by record.
+class LogWriter
+{
+public:
+  LogWriter(const std::string& path, LogFormat format = TEXT_LOG, int blockSize = 1 << 16, int maxBlocks = 16, double period = 1.0);
+
+  virtual ~LogWriter();
+
+  inline bool IsOpen() { return file.is_open(); };
+
+  void Write(const char *data, size_t size);
+
+  // Wait until everything written so far is on disk
+  void Flush();
+
+  // Records dropped on a full queue
+  inline long Dropped() { std::lock_guard<std::mutex> lock(mtx); return dropped; };
+
+protected:
+  void Loop();
+
+private:
+  std::string* NewBlock();
+
+  std::ofstream file;
+  LogFormat format;
+  size_t blockSize, maxBlocks;
+  double period;
+
+  std::string *current;          // Block being filled
+  std::deque<std::string*> queue, pool;
+  std::thread writer;
+  std::mutex mtx;
+  std::condition_variable ready, idle;
+  bool flush, writing, done;
+  long dropped;
+};
+
+// std::ostream front end of a LogWriter: the text is handed over as one
+// record at each flush (std::endl), so lines of different threads do not
+// mix. One LogBuffer per thread; NULL writer -> text is discarded.
+// The writer is looked up through *writer under lock at each flush, so its
+// owner can replace it (under the same lock) while buffers are alive.
+class LogBuffer : public std::streambuf
+{
+public:
+  LogBuffer(LogWriter *const *writer, std::mutex *lock) : writer(writer), lock(lock) {}
+
+  virtual ~LogBuffer() { sync(); }
+
+protected:
+  int overflow(int c);
+  std::streamsize xsputn(const char *s, std::streamsize n);
+  int sync();
+
+private:
+  LogWriter *const *writer;
+  std::mutex *lock;
+  std::string line;
+};
+
+#endif // LOGWRITER_H
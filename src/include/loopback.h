@@ -0,0 +1,115 @@
+/*
+ *  loopback.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+#include <cmath>
+#include <vector>
+#include <boost/random.hpp>
+#include "include/agent.h"
+#include "include/eventport.h"
+#include "include/sender.h"
+#include "include/receiver.h"
+
+// Synthetic stand-in for the network: collects the spikes sent by the
+// environment and produces the network spikes of each tick
+class Responder : public EventOutput
+{
+public:
+  virtual ~Responder() {}
+
+  virtual void InsertEvent(double t, int id) {}
+
+  // Deliver the network spikes in [t0, t1) to handler
+  virtual void Respond(double t0, double t1, EventInput *handler) = 0;
+
+  virtual void Save(std::ostream& out) {}
+  virtual void Load(std::istream& in) {}
+};
+
+// Independent Poisson spike trains at a fixed rate per population
+// (channels are contiguous in population order, as in Receiver)
+class PoissonResponder : public Responder
+{
+public:
+  // sizes -> neurons per population, rates -> firing rate per population [Hz]
+  PoissonResponder(int *sizes, double *rates, int numPops, unsigned int seed = 1000);
+
+  virtual ~PoissonResponder();
+
+  void InsertEvent(double t, int id);
+  void Respond(double t0, double t1, EventInput *handler);
+
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
+
+  inline long Received() { return received; };
+  inline long Emitted() { return emitted; };
+
+private:
+  typedef boost::mt19937 genType;
+  typedef boost::uniform_real<> distType;
+  typedef boost::variate_generator<genType&, distType> numGen;
+
+  genType *generator;
+  distType *distribution;
+  numGen *numberGenerator;
+
+  std::vector<double> rate,   // Rate per channel [Hz]
+                      next;   // Next spike time per channel [s]
+
+  long received, emitted;
+};
+
+// Agent closing the loop in process: Sender spikes go to the responder and
+// its answer reaches Receiver at each tick. No MUSIC/MPI launch needed.
+class LoopbackAgent : public Agent, public EventOutput
+{
+public:
+  LoopbackAgent(Responder *responder, Receiver *inhandler, double TICK);
+
+  virtual ~LoopbackAgent();
+
+  void SetSender(Sender *outhandler);
+
+  double Time();
+  void SendState(arma::vec& q, double tickt);
+  void SendReward(double reward, double tickt);
+  double Tick();
+  double GetAction(double tickt);
+  double GetDopa(double tickt);
+  double* GetValue(double tickt, double reward);
+
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
+
+  inline void InsertEvent(double t, int id) { responder->InsertEvent(t, id); };
+
+private:
+  Responder *responder;
+  Sender *outhandler;
+  Receiver *inhandler;
+
+  double t, tick;
+};
+
+#endif // LOOPBACK_H
@@ -0,0 +1,67 @@
+/*
+ *  musicagent.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MUSICAGENT_H
+#define MUSICAGENT_H
+
+#include <music.hh>
+#include "include/agent.h"
+#include "include/sender.h"
+#include "include/receiver.h"
+#include "include/traffic.h"
+
+// Agent running in another MUSIC application (BeeBrain): spikes leave through
+// Sender, come back through Receiver and are exchanged at each runtime tick.
+// With ticks = false the runtime is ticked and finalized by someone else
+// (Swarm) and Tick only reads the time. Without outhandler nothing is sent
+// (replica of a bee whose output belongs to another rank). With a Traffic
+// the ticking agent times every runtime tick and closes its traffic row.
+class MusicAgent : public Agent
+{
+public:
+  MusicAgent(MUSIC::Runtime *runtime, Sender *outhandler, Receiver *inhandler, bool ticks = true);
+
+  virtual ~MusicAgent();
+
+  double Time();
+  void SendState(arma::vec& q, double tickt);
+  void SendReward(double reward, double tickt);
+  double Tick();
+  double GetAction(double tickt);
+  double GetDopa(double tickt);
+  double* GetValue(double tickt, double reward);
+  void Finalize();
+
+  void SetTraffic(Traffic *traffic);
+
+  // Sender/Receiver state; the remote network is not part of the snapshot
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
+
+private:
+  MUSIC::Runtime *runtime;
+  Sender *outhandler;
+  Receiver *inhandler;
+  bool ticks;
+  Traffic *traffic;
+};
+
+#endif // MUSICAGENT_H
@@ -0,0 +1,82 @@
+/*
+ *  musicport.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MUSICPORT_H
+#define MUSICPORT_H
+
+#include <vector>
+#include <music.hh>
+#include "include/eventport.h"
+#include "include/receiver.h"
+
+// Events go out through a MUSIC event port
+class MusicEventOutput : public EventOutput
+{
+public:
+  MusicEventOutput(MUSIC::EventOutputPort *_port) : port(_port) {}
+
+  inline void InsertEvent(double t, int id) { port->insertEvent(t, MUSIC::GlobalIndex(id)); }
+
+private:
+  MUSIC::EventOutputPort *port;
+};
+
+// Rates published through a MUSIC continuous port, channels
+// [first, first+count) of the port are local; map during the setup phase
+class MusicRateOutput : public RateOutput
+{
+public:
+  MusicRateOutput(MUSIC::ContOutputPort *port, int _first, int count)
+    : first(_first), rates(count > 0 ? count : 1, 0.0), data(&rates[0], MPI::DOUBLE, _first, count) { port->map(&data); }
+
+  inline void SetRate(int id, double rate) { rates[id - first] = rate; }
+
+private:
+  int first;
+  std::vector<double> rates;
+  MUSIC::ArrayData data;
+};
+
+// Events coming from a MUSIC event input port are handed to an EventInput
+class MusicEventInput : public MUSIC::EventHandlerGlobalIndex
+{
+public:
+  MusicEventInput(EventInput *_handler) : handler(_handler) {}
+
+  inline void operator () (double t, MUSIC::GlobalIndex id) { handler->HandleEvent(t, id); }
+
+private:
+  EventInput *handler;
+};
+
+// Readout partial sums of the ranks in comm (one allreduce per tick)
+class MpiPartialSum : public PartialSum
+{
+public:
+  MpiPartialSum(MPI::Intracomm _comm) : comm(_comm) {}
+
+  inline void Reduce(double *sums, int n) { comm.Allreduce(MPI::IN_PLACE, sums, n, MPI::DOUBLE, MPI::SUM); }
+
+private:
+  MPI::Intracomm comm;
+};
+
+#endif // MUSICPORT_H
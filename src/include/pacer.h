@@ -0,0 +1,78 @@
+/*
+ *  pacer.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <time.h>
+#include <stdint.h>
+
+// Wall clock deadlines for one periodic task (CLOCK_MONOTONIC).
+// Wait() paces a loop with absolute-deadline sleeps: a cycle that ends after
+// its deadline is a miss, otherwise the thread sleeps until the deadline and
+// the late wake-up is the jitter. Release()/Complete() account a job whose
+// cycle is driven by another task (the neural tick inside the plant loop):
+// jitter is the release delay, a miss a response longer than the period.
+class Pacer
+{
+public:
+  Pacer(const std::string& name, double period);
+
+  virtual ~Pacer();
+
+  // First release is now
+  void Start();
+
+  // End of a cycle: sleep until the next deadline
+  void Wait();
+
+  // Job of a task paced by someone else
+  void Release();
+  void Complete();
+
+  // Jobs, misses, jitter mean/p99/max and worst overrun [us]
+  void Report(std::ostream& out);
+
+  inline long Jobs() { return jobs; };
+  inline long Misses() { return misses; };
+
+  // Bind the calling thread to cpu, false when not permitted
+  static bool PinThread(int cpu);
+
+protected:
+  static int64_t Now();
+  void AddJitter(int64_t ns);
+
+private:
+  std::string name;
+  int64_t period,
+          release;       // Current release [ns]
+
+  long jobs, misses, resyncs;
+  int64_t jitterSum, jitterMax, overrunMax;
+  std::vector<long> jitterBins;
+};
+
+#endif // PACER_H
@@ -2,16 +2,28 @@
 #define PLOTTER_H
 
 #include <string>
+#include <iostream>
+#include <cstdlib>
+#include <sstream>
 #include <algorithm>
+#include <vector>
+#include <thread>
 #include <armadillo>
 #include <dynplot.hh>
 #include <boost/tuple/tuple.hpp>
 #include "gnuplot-iostream.h"
+#include "include/columnfile.h"
+#include "include/connfile.h"
+
+// Value map cell of the samples falling into it: value of the last one,
+// mean value or number of visits
+enum ValueAggregate { VALUE_LAST, VALUE_MEAN, VALUE_COUNT };
 
 class Plotter
 {
 public:
-  Plotter(const std::string& filePath, bool LOAD);
+  // overview -> rate [Hz] of the decimated level to load (0 -> full resolution)
+  Plotter(const std::string& filePath, bool LOAD, double overview = 0, ValueAggregate aggregate = VALUE_LAST);
   Plotter();
   virtual ~Plotter();
 
@@ -34,13 +46,21 @@ public:
   void Results(double start, double end);
 
 protected:
-  void BuilValueMat();
+  // channels -> expected column count, to read old channels x samples .dat files
+  const arma::mat& Load(const std::string& name, int channels);
+  void BuilValueMat(ValueAggregate aggregate);
+  void BinValues(int first, int last, double vRes, std::vector<double>& sum, std::vector<long>& count);
   void XYZSurfReshape(arma::mat& A);
   inline double WrapTo2Pi(double angle) {return angle - floor(angle/(2*pi))*(2*pi);}
 
 private:
   Gnuplot gp;
-  std::string folder, saveFolder;
+  std::string folder, saveFolder, valueName;
+
+  // Recordings loaded by Load: views on the mapped single-block files (the
+  // readers stay open with them) or copies for the other layouts
+  std::vector<ColumnReader*> readers;
+  std::vector<arma::mat*> loaded;
 
   char *cmd;
 
@@ -55,6 +75,13 @@ private:
 
   int lengthSim, dummy;
 
+  // Value map bins: row/column of valueMat holding bin n - binMin (-1 -> none)
+  long rowMin, colMin;
+  std::vector<int> rowOf, colOf;
+
+  double overview,
+         sampleRate;  // Rate of simtime as loaded [Hz], 0 -> unknown
+
   const double pi;
 
   double maxTime, limTime[2], freq,
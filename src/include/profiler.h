@@ -0,0 +1,147 @@
+/*
+ *  profiler.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <ostream>
+#include <stdint.h>
+
+// Per-phase latency histograms of the hot path. A phase is opened with
+// PROFILE_SCOPE("name") and timed until the end of the enclosing block.
+// Built only with ./configure --enable-profile (ROBOBEE_PROFILE), otherwise
+// the macro expands to nothing and Report prints an empty table.
+//
+// Log-linear buckets on nanoseconds: 16 sub-buckets per power of two, so a
+// percentile is off by at most 1/16. Counters are atomic, phases may be
+// timed from any thread (render thread included).
+//
+// With StartTrace every span is also kept in a preallocated ring of the
+// calling thread (the newest capacity spans survive) and WriteTrace dumps
+// them as Chrome/Perfetto trace events, one process track per rank.
+class Profiler
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Id of phase name, registered on first use
+  static int Phase(const char *name);
+
+  static void Add(int phase, Clock::time_point start, Clock::time_point end);
+
+  // count, mean, p50, p99, max [us] of every phase
+  static void Report(std::ostream& out);
+  static bool Save(const std::string& fname);
+
+  // Drop the samples collected so far (phases stay registered)
+  static void Reset();
+
+  static const int SubBits = 4,
+                   NumBuckets = (65 - SubBits)*(1 << SubBits);
+
+  // Keep capacity spans per thread from now on, pid -> track (MPI rank)
+  static void StartTrace(int pid, int capacity = 1 << 16);
+
+  // Track name of the calling thread
+  static void NameThread(const std::string& name);
+
+  // Comma separated trace events (no enclosing array), call once the
+  // traced threads are done
+  static void WriteTrace(std::ostream& out);
+
+  // Complete {"traceEvents": [...]} document of this process
+  static bool SaveTrace(const std::string& fname);
+
+  static int Bucket(uint64_t ns);
+  static uint64_t BucketTop(int bucket);   // Largest value held by bucket
+
+private:
+  struct Histogram
+  {
+    std::string name;
+    std::atomic<uint64_t> count, sum, max;
+    std::atomic<uint64_t> bins[NumBuckets];
+  };
+
+  static const int MaxPhases = 64;
+
+  static Histogram phases[MaxPhases];
+  static std::atomic<int> numPhases;
+
+  static uint64_t Percentile(Histogram& h, uint64_t count, double p);
+
+  struct Span
+  {
+    int phase;
+    int64_t start, duration;   // [ns] since StartTrace
+  };
+
+  struct TraceBuffer
+  {
+    int tid;
+    std::string name;
+    std::vector<Span> spans;
+    uint64_t written;
+  };
+
+  static TraceBuffer* ThreadBuffer();
+
+  static std::atomic<bool> tracing;
+  static int tracePid, traceCapacity;
+  static Clock::time_point traceStart;
+  static std::vector<TraceBuffer*> buffers;
+};
+
+class ScopedTimer
+{
+public:
+  inline ScopedTimer(int _phase) : phase(_phase), start(Profiler::Clock::now()) {};
+
+  inline ~ScopedTimer() {
+    Profiler::Add(phase, start, Profiler::Clock::now());
+  };
+
+private:
+  int phase;
+  Profiler::Clock::time_point start;
+};
+
+#define PROFILE_CAT2(a, b) a##b
+#define PROFILE_CAT(a, b) PROFILE_CAT2(a, b)
+
+#ifdef ROBOBEE_PROFILE
+#define PROFILE_SCOPE(name) \
+  static const int PROFILE_CAT(profilePhase, __LINE__) = Profiler::Phase(name); \
+  ScopedTimer PROFILE_CAT(profileTimer, __LINE__)(PROFILE_CAT(profilePhase, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#endif // PROFILER_H
@@ -22,12 +22,25 @@
 #ifndef RECEIVER_H
 #define RECEIVER_H
 
-#include <music.hh>
 #include <vector>
+#include <algorithm>
+#include "include/eventport.h"
 #include "include/decoder.h"
+#include "include/checkpoint.h"
+#include "include/traffic.h"
 
-//Create a son of the class MUSIC::EventHandlerGLobalIndex to receive spikes from network
-class Receiver : public MUSIC::EventHandlerGlobalIndex
+// Combines the partial readout sums of the ranks sharing a bee's readout
+class PartialSum
+{
+public:
+	virtual ~PartialSum() {}
+
+	// Element-wise sum of sums[0..n) over all the ranks, in place
+	virtual void Reduce(double *sums, int n) = 0;
+};
+
+// Receive spikes from network (MusicEventInput or any in-process source)
+class Receiver : public EventInput
 {
 public:
 
@@ -37,7 +50,7 @@ public:
 
 	virtual ~Receiver();
 
-	void operator () (double t, MUSIC::GlobalIndex id);
+	void HandleEvent(double t, int id);
 
 	std::vector <std::vector <double> >* GetSpikes(int pop);
 
@@ -50,7 +63,25 @@ public:
 	double GetDopa(double tickt);
 	double GetForce(int k);
 
+	// Partial ownership: only channels [first, first+count) reach this
+	// Receiver, the kernel sums of every tick are combined by reducer
+	void SetPartial(int first, int count, PartialSum *reducer);
+
+	// Events received per population, after SetCritic/SetActor/SetDopa
+	// (NULL -> off)
+	void SetTraffic(Traffic *traffic);
+
+	// Checkpoint: spikes still inside the decoding window at tickt,
+	// shifted by shift [s] when loaded into a new time base
+	void Save(std::ostream& out, double tickt);
+	void Load(std::istream& in, double shift = 0);
+
 protected:
+	// Kernel sums of the owned neurons at tickt, reduced once per tick
+	void Decode(double tickt);
+
+	// Owned neurons [lo, hi) of population pop
+	void Owned(int pop, int& lo, int& hi);
 
 private:
 	// Spikes Storing
@@ -68,6 +99,16 @@ private:
 			idDopa, sizeDopa;
 
 	Decoder *spikeFilter;
+
+	// Owned channels and readout sums: critic value, critic derivative,
+	// actor weighted force, actor activity, dopa
+	int ownFirst, ownEnd;
+	PartialSum *reducer;
+
+	Traffic *traffic;
+	std::vector<int> groups;
+	double sums[5], decodedAt;
+	bool decoded;
 };
 
 #endif // RECEIVER_H
@@ -0,0 +1,114 @@
+/*
+ *  recorder.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <algorithm>
+#include "include/columnfile.h"
+
+enum RecordFormat { TEXT, BINARY };
+
+// Streams named channels to folder/<name>.bin (columnfile.h, one block per
+// chunk, compacted to a single block on Close) or folder/<name>.dat (text,
+// one sample per line).
+// Samples are buffered in fixed-size chunks; full chunks go to a background
+// writer thread and are recycled, so memory stays bounded for any run length.
+// Each channel can also feed decimated levels, folder/<name>.r<rate>, holding
+// the min, max and mean of every column over each window.
+class Recorder
+{
+public:
+  // chunkSize -> samples per chunk, maxChunks -> chunks queued before Record blocks
+  Recorder(const std::string& folder, RecordFormat format = BINARY, int chunkSize = 1000, int maxChunks = 64);
+
+  virtual ~Recorder();
+
+  // Decimated levels [Hz] added to the channels registered afterwards
+  void SetLevels(double *rates, int numLevels);
+
+  // Register a channel of size values per sample, returns its handle
+  // rate -> samples per second of Record calls, columns -> column names
+  // separated by spaces, decimate -> keep one sample every decimate
+  int AddChannel(const std::string& name, int size, double rate = 0, const std::string& columns = "", int decimate = 1);
+
+  // Append one sample (size values) to channel
+  void Record(int channel, const double *data);
+
+  // Flush and wait until everything is on disk, then make every .bin a
+  // single block (read by Plotter without copies)
+  void Close();
+
+protected:
+  void Flush();
+  void Write();
+
+private:
+  struct Chunk
+  {
+    int channel, samples;
+    std::vector<double> data;
+  };
+
+  // min/max/mean accumulator of a decimated level
+  struct Level
+  {
+    int channel, factor, count;
+    std::vector<double> acc;
+  };
+
+  int Open(const std::string& name, int size, double rate, const std::string& columns);
+  void Append(int channel, const double *data);
+  Chunk* NewChunk(int channel);
+  void Push(Chunk *chunk);
+
+  std::string folder;
+  RecordFormat format;
+  int chunkSize, maxChunks, allocated;
+
+  std::vector<double> levelRates;
+  std::vector<int> sizes, decimate;
+  std::vector<long> counts;
+  std::vector < std::vector<Level> > levels;
+  std::vector<std::ofstream*> files;
+  std::vector<ColumnWriter*> columnFiles;
+  std::vector<std::string> paths;
+  std::vector<Chunk*> current;   // Chunk being filled per channel
+
+  std::deque<Chunk*> queue,      // Full chunks waiting for the writer
+                     pool;       // Written chunks ready for reuse
+  std::thread writer;
+  std::mutex mtx;
+  std::condition_variable ready, freed;
+  bool done;
+};
+
+#endif // RECORDER_H
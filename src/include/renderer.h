@@ -0,0 +1,95 @@
+/*
+ *  renderer.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <armadillo>
+#include <dynplot.hh>
+#include "include/triplebuffer.h"
+#include "include/capture.h"
+#include "include/profiler.h"
+
+// Draws the RoboBee on its own thread. The simulation publishes the pose at
+// any rate without blocking; the render thread owns the OpenGL context and
+// draws the latest pose at its own frame rate, intermediate poses are dropped.
+// Captured video is taken in simulation time instead: the pose published at
+// each 1/fps step of simulation time is queued and rendered into the video,
+// so the video plays at simulation speed however fast the run goes. The queue
+// holds as many poses as the capture pool; poses arriving when it is full are
+// dropped and counted as late.
+class Renderer
+{
+public:
+  Renderer(const std::string& title, int length, int height, double fps, const std::string& graphicFolder);
+
+  virtual ~Renderer();
+
+  // Copy every rendered frame into capture (call before Start)
+  void SetCapture(FrameCapture *capture);
+
+  // Hidden window and software OpenGL, for capture without a display
+  void SetHeadless(bool headless);
+
+  void Start();
+  void Stop();
+
+  // Simulation side: latest state (q as in Robobee) at simulation time t
+  void Publish(const arma::vec& q, double t);
+
+  inline long Published() { return published; };
+  inline long Rendered() { return rendered; };
+  inline long Late() { std::lock_guard<std::mutex> lock(frameLock); return late; };
+
+protected:
+  void Loop();
+
+private:
+  struct Pose
+  {
+    double pos[3], rot[3], t;
+  };
+
+  TripleBuffer<Pose> poses;
+  std::deque<Pose> frames;
+  std::mutex frameLock;
+  double frameStart;
+  long frameCount, late;
+  std::thread thread;
+  std::atomic<bool> running;
+  std::atomic<long> rendered;
+  long published;
+
+  FrameCapture *capture;
+
+  std::string title, graphicFolder;
+  int length, height;
+  double fps;
+  bool headless;
+};
+
+#endif // RENDERER_H
@@ -25,6 +25,7 @@
 #include <cmath>
 #include <vector>
 #include <armadillo>
+#include "include/checkpoint.h"
 
 class Robobee
 {
@@ -34,6 +35,8 @@ public:
 	~Robobee(); 																									// Destroyer
 	void InitRobot(arma::vec& q0);													// Set State
 	arma::vec& BeeDynamics(arma::vec& u);												// Bee Dynamic
+	void Save(std::ostream& out);																// Checkpoint
+	void Load(std::istream& in);
 
 protected:
 	void Body2World(); 				// Get Rotation Matrix
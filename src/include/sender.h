@@ -23,14 +23,15 @@
 #define SENDER_H
 
 #include <armadillo>
-#include <music.hh>
+#include "include/eventport.h"
 #include "include/encoder.h"
+#include "include/traffic.h"
 
 class Sender
 {
 public:
   // Constructor
-  Sender(MUSIC::EventOutputPort *outport, double TICK);
+  Sender(EventOutput *outport, double TICK);
 
   // Default Constructor
   Sender();
@@ -39,6 +40,13 @@ public:
   virtual ~Sender();
 
   void CreatePlaceCells (int numState, int *idState, int *resState, bool *typeState, double *rangeState, double maxRate);
+
+  // Rate coded mode: place cell (state) and/or reward channel rates go to
+  // rateport instead of Poisson events (NULL -> events)
+  void SetRateOutput(RateOutput *rateport, bool state, bool reward);
+
+  // Events sent per tick: place cells, reward+ and reward- (NULL -> off)
+  void SetTraffic(Traffic *traffic);
   void SendState (arma::vec& q, double tickt);
   void SendReward(double reward, double tickt);
   double InputRate(
@@ -46,10 +54,20 @@ public:
     double minRate, double maxRate,
     double minRew, double maxRew);
 
+  // Checkpoint (encoder state)
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
+
 protected:
 
 private:
-  MUSIC::EventOutputPort *outputPort;
+  EventOutput *outputPort;
+  RateOutput *stateRates,
+             *rewardRates;
+
+  Traffic *traffic;
+  EventCounter *counter;     // In front of outputPort while counting
+  int placeGroup, rewExGroup, rewInGroup;
   double pi;
 
   std::vector < std::vector<double> > pCells;
@@ -0,0 +1,142 @@
+/*
+ *  spikingagent.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SPIKINGAGENT_H
+#define SPIKINGAGENT_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/random.hpp>
+#include "include/agent.h"
+#include "include/eventport.h"
+#include "include/sender.h"
+#include "include/receiver.h"
+#include "include/checkpoint.h"
+#include "include/connfile.h"
+
+// In-process replacement of the NEST BeeBrain (pynetwork/bee_classes.py).
+// Place cells (parrots) project with dopamine modulated STDP synapses onto
+// the critic and actor (iaf_chs_2007), the actor has lateral Mexican-hat
+// connectivity and the dopaminergic population (iaf_cond_alpha) is driven by
+// a Poisson baseline plus the reward channels. Clock driven with h = 0.1 ms.
+// Place cell input comes from Sender (the agent is its EventOutput) and
+// critic/actor/dopa spikes are delivered to Receiver on channels 0..209.
+// In rate coded mode (RateOutput) the input spikes are drawn here.
+class SpikingAgent : public Agent, public EventOutput, public RateOutput
+{
+public:
+  // nCells -> number of place cells, pops -> [critic, actor, dopa] sizes
+  SpikingAgent(int nCells, int *pops, double TICK, Receiver *inhandler, unsigned int seed = 1000);
+
+  virtual ~SpikingAgent();
+
+  void SetSender(Sender *outhandler);
+
+  // Agent
+  double Time();
+  void SendState(arma::vec& q, double tickt);
+  void SendReward(double reward, double tickt);
+  double Tick();
+  double GetAction(double tickt);
+  double GetDopa(double tickt);
+  double* GetValue(double tickt, double reward);
+
+  // EventOutput: spikes coming from Sender
+  void InsertEvent(double t, int id);
+
+  // RateOutput: Poisson input drawn locally at each tick
+  void SetRate(int id, double rate);
+
+  // Save ids and connections in the BeeBrain format (source, target, w_start, w_end)
+  void SaveNetwork(const std::string& folder);
+
+  // Checkpoint: complete network state (neurons, traces, weights, queued spikes)
+  void Save(std::ostream& out);
+  void Load(std::istream& in);
+
+protected:
+  void DrawRates();          // Poisson input of the coming tick from rates
+  void Update();             // One integration step of the whole network
+  void UpdateWeights();      // Dopamine modulated weight change
+  void PlaceCellSpike(int i);
+  void ReadoutSpike(int i);   // Critic/Actor
+  void DopaSpike(int i);
+
+private:
+  typedef boost::mt19937 genType;
+  typedef boost::uniform_real<> distType;
+  typedef boost::variate_generator<genType&, distType> numGen;
+
+  genType *generator;
+  distType *distribution;
+  numGen *numberGenerator;
+
+  Sender *outhandler;
+  Receiver *inhandler;
+
+  // Populations
+  int nCells, nCritic, nActor, nReadout, nDopa,
+      stepsPerTick, ringSize,
+      plasticPeriod, lateralDelay;
+
+  long step;                 // Integration steps done so far
+  double h;                  // Resolution [ms]
+
+  // Sender channels (place cells and reward) spiking at each ring slot
+  std::vector < std::vector<int> > inRing;
+  std::vector<double> rates;     // Rate coded channels [Hz]
+  std::vector<int> rateIds;      // Channels with a rate set
+
+  // Critic + Actor (iaf_chs_2007)
+  double tau_epsp, tau_reset, U_th, U_epsp, U_reset,
+         P11, P21, P30;
+  std::vector<double> iSyn, vSyn, vSpike;
+  std::vector < std::vector<double> > readoutRing; // incoming weights per delay slot
+
+  // Dopaminergic neurons (iaf_cond_alpha)
+  double E_L, g_L, E_ex, E_in, V_reset, t_ref,
+         tau_ex, tau_in, PEx, PIn,
+         baseRate, baseWeight, rewWeight;
+  std::vector<double> V, C_m, V_th, gEx, dgEx, gIn, dgIn, refr, nextBase;
+
+  // Plastic synapses (place cells -> critic/actor), CSR by place cell,
+  // postSyn lists the synapses reaching each readout neuron
+  std::vector<int> rowPtr, pre, post;
+  std::vector < std::vector<int> > postSyn;
+  std::vector<double> w, wStart, c;
+
+  // Actor lateral synapses, CSR by actor neuron
+  std::vector<int> latPtr, latPost;
+  std::vector<double> latW;
+
+  // stdp_dopamine_synapse
+  double A_plus, A_minus, w_max, w_min, b, tau_c, tau_n, tau_plus, tau_minus,
+         n, decayPlus, decayMinus, decayN, decayC, intN, intB;
+  std::vector<double> kPlus, kMinus;
+
+  // Output spikes of the current tick (channel, time [s])
+  std::vector<int> outId;
+  std::vector<double> outTime;
+};
+
+#endif // SPIKINGAGENT_H
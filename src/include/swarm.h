@@ -0,0 +1,70 @@
+/*
+ *  swarm.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef SWARM_H
+#define SWARM_H
+
+#include <vector>
+#include "include/agent.h"
+#include "include/episoderunner.h"
+#include "include/pacer.h"
+
+// Independent bees sharing one agent time base (one MUSIC runtime per rank).
+// Each plant step runs the controller and encoding of every bee, ticks the
+// clock once when a neural tick is due and then completes every bee's step,
+// so all bees' spikes go out in the same tick. The bees' own agents must not
+// tick (MusicAgent with ticks = false).
+class Swarm
+{
+public:
+  // clock -> agent whose Tick advances the shared time base
+  Swarm(Agent *clock, double simt);
+
+  virtual ~Swarm();
+
+  // Runner already Started against its bee agent, false (not added) when
+  // its time differs from the bees already in the swarm
+  bool Add(EpisodeRunner *runner);
+
+  // Plant steps of the whole swarm paced against the wall clock (NULL -> off)
+  void SetPacing(Pacer *plant);
+
+  // False when the bees disagree on the neural tick (out of lockstep)
+  bool Step();
+
+  // A rank without bees keeps ticking until simt
+  inline bool Running() { return runners.empty() ? clock->Time() < simt : runners[0]->Running(); };
+
+  void Finalize();
+
+  inline int Size() { return runners.size(); };
+  inline EpisodeRunner* Bee(int i) { return runners[i]; };
+
+private:
+  Agent *clock;
+  double simt;
+  std::vector<EpisodeRunner*> runners;
+  Pacer *plantPacer;
+  bool started;
+};
+
+#endif // SWARM_H
@@ -0,0 +1,102 @@
+/*
+ *  telemetry.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+// Live telemetry in a POSIX shared memory ring (/dev/shm/robobee.<pid>).
+// One writer, any number of readers; every slot carries a sequence number
+// (odd while being written) so readers detect torn or overwritten samples
+// without ever blocking the simulation.
+struct TelemetrySample
+{
+  double t,
+         q[12],
+         u[4],
+         reward, tdError,
+         value, policy, dopa;
+  int trials;
+};
+
+struct TelemetrySlot
+{
+  std::atomic<uint64_t> seq;
+  TelemetrySample sample;
+};
+
+struct TelemetryHeader
+{
+  char magic[8];
+  uint32_t capacity, pid;
+  std::atomic<uint64_t> written;   // Samples published so far
+};
+
+class Telemetry
+{
+public:
+  // name -> shared memory object, empty -> /robobee.<pid>
+  Telemetry(const std::string& name = "", int capacity = 4096);
+
+  virtual ~Telemetry();
+
+  inline bool IsOpen() { return header != NULL; };
+  inline const std::string& Name() { return name; };
+
+  void Publish(const TelemetrySample& sample);
+
+private:
+  std::string name;
+  size_t size;
+  TelemetryHeader *header;
+  TelemetrySlot *slots;
+  uint64_t count;
+};
+
+class TelemetryReader
+{
+public:
+  TelemetryReader(const std::string& name);
+
+  virtual ~TelemetryReader();
+
+  inline bool IsOpen() { return header != NULL; };
+  inline int Pid() { return header->pid; };
+
+  // Samples published so far
+  inline uint64_t Written() { return header->written.load(std::memory_order_acquire); };
+
+  // Sample number n, false when overwritten or being written
+  bool Read(uint64_t n, TelemetrySample& sample);
+
+  // Oldest sample still available
+  uint64_t Oldest();
+
+private:
+  size_t size;
+  TelemetryHeader *header;
+  TelemetrySlot *slots;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,88 @@
+/*
+ *  traffic.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+#include "include/recorder.h"
+
+// Per tick traffic of the env <-> agent link: events of every channel group
+// (Sender and Receiver count them), bytes on the wire, how long the runtime
+// tick blocks waiting for the other side and the age of the oldest spike
+// delivered (how late the agent output arrives, IN_LATENCY included).
+// One row per tick goes to a Recorder channel, Report sums up the run.
+// Counters are not atomic: count on the thread that ticks, or between ticks.
+class Traffic
+{
+public:
+  Traffic();
+
+  virtual ~Traffic();
+
+  // Counter of events leaving (out) or entering the process, returns its
+  // handle (the same one for a name already registered)
+  int AddGroup(const std::string& name, bool out);
+
+  // Row per tick in recorder channel name: t wait age <groups> bytesOut bytesIn
+  // (groups must be registered before)
+  void SetLog(Recorder *recorder, const std::string& name, double rate);
+
+  inline void Count(int group, long events) { counts[group] += events; };
+
+  // Event of an input group with spike time t
+  inline void Receive(int group, double t) {
+    counts[group]++;
+    if (t < oldest)
+      oldest = t;
+  };
+
+  // Tick at time t (after the exchange) that blocked wait seconds
+  void EndTick(double t, double wait);
+
+  // Events per group, bytes, tick wait and spike age over the run
+  void Report(std::ostream& out);
+
+  // Bytes of an event on the wire (spike time + global index)
+  static const int EventBytes = sizeof(double) + sizeof(int);
+
+private:
+  std::vector<std::string> names;
+  std::vector<bool> outgoing;
+  std::vector<long> counts,        // Current tick
+                    totals, peaks; // Whole run
+
+  double oldest;                   // Oldest spike received this tick
+  long ticks, bytesOut, bytesIn;
+  double ageSum, ageMax;
+  uint64_t waitSum, waitMax;       // [ns]
+  std::vector<long> waitBins;      // Profiler buckets
+
+  Recorder *recorder;
+  int channel;
+  std::vector<double> row;
+};
+
+#endif // TRAFFIC_H
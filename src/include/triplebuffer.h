@@ -0,0 +1,58 @@
+/*
+ *  triplebuffer.h
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single producer/single consumer triple buffer. The writer never
+// waits and the reader always gets the latest complete value; values written
+// in between two reads are dropped.
+template<class T> class TripleBuffer
+{
+public:
+  TripleBuffer() : shared(1), back(0), front(2) {}
+
+  // Producer side
+  inline void Write(const T& value) {
+    slots[back] = value;
+    back = shared.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+  };
+
+  // Consumer side: false when nothing new was written since the last read
+  inline bool Read(T& value) {
+    if (!(shared.load(std::memory_order_acquire) & FRESH))
+      return false;
+    front = shared.exchange(front, std::memory_order_acq_rel) & INDEX;
+    value = slots[front];
+    return true;
+  };
+
+private:
+  enum { INDEX = 3, FRESH = 4 };
+
+  T slots[3];
+  std::atomic<int> shared;  // Slot in the middle, FRESH when not read yet
+  int back, front;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -19,37 +19,91 @@
  *
  */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include "include/iomanager.h"
 
+static const char vecMagic[8] = "RBVEC1";
+
 Iomanager::Iomanager(const std::string& _loadDir, const std::string& _saveDir){
   loadDir = _loadDir;
   saveDir = _saveDir;
+  textLog = NULL;
+  binLog = NULL;
 }
 
-Iomanager::Iomanager() {}
+Iomanager::Iomanager()
+{
+  textLog = NULL;
+  binLog = NULL;
+}
 
 Iomanager::~Iomanager()
 {
   if (inStream.is_open())
     inStream.close();
-  else if (outStream.is_open())
-    outStream.close();
+
+  // Pending text of every thread goes to the writer before it drains
+  for (std::map<std::thread::id, std::ostream*>::iterator it = streams.begin(); it != streams.end(); ++it) {
+    std::streambuf *buf = it->second->rdbuf();
+    delete it->second;
+    delete buf;
+  }
+  delete textLog;
+  delete binLog;
 }
 
 void Iomanager::SetStream(const std::string& fname, const std::string& stype)
 {
   if (stype == "in")
     inStream.open(loadDir+fname);
-  else if (stype == "out")
-    outStream.open(saveDir+fname, std::ofstream::out);
+  else if (stype == "out") {
+    // The LogBuffers of Print look textLog up under streamLock
+    std::lock_guard<std::mutex> lock(streamLock);
+    delete textLog;
+    textLog = new LogWriter(saveDir+fname, TEXT_LOG);
+  }
+  else if (stype == "bin") {
+    delete binLog;
+    binLog = new LogWriter(saveDir+fname, BINARY_LOG);
+  }
 }
 
-std::ofstream& Iomanager::Print()
+std::ostream& Iomanager::Print()
 {
-  if (!outStream.is_open())
-    std::cerr << "/* No Output Stream Set */" << '\n';
+  std::lock_guard<std::mutex> lock(streamLock);
+  std::ostream*& stream = streams[std::this_thread::get_id()];
+
+  if (!stream) {
+    if (!textLog)
+      std::cerr << "/* No Output Stream Set */" << '\n';
+    stream = new std::ostream(new LogBuffer(&textLog, &streamLock));
+  }
 
-  return outStream;
+  return *stream;
+}
+
+void Iomanager::Record(const void *data, size_t size)
+{
+  if (binLog)
+    binLog->Write((const char*)data, size);
+}
+
+void Iomanager::Flush()
+{
+  if (textLog)
+    textLog->Flush();
+  if (binLog)
+    binLog->Flush();
 }
 
 std::ifstream& Iomanager::Read()
@@ -60,31 +114,139 @@ std::ifstream& Iomanager::Read()
   return inStream;
 }
 
-void Iomanager::SaveVec(const std::string& fname, std::vector<double> *vect)
+void Iomanager::SaveVec(const std::string& fname, std::vector<double> *vect, VecFormat format)
 {
   std::string path = saveDir + fname;
+
+  if (format == BINARY_VEC) {
+    VecHeader header;
+    memcpy(header.magic, vecMagic, sizeof(header.magic));
+    header.count = vect->size();
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+      return;
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(vect->data(), sizeof(double), vect->size(), file);
+    fclose(file);
+    return;
+  }
+
   std::ofstream outData (path.c_str(), std::ofstream::out);
 
   for (int i=0; i != vect->size(); ++i)
-      outData << vect->at(i) << std::endl;
+      outData << vect->at(i) << '\n';
 
   outData.close();
 }
 
 std::vector<double> Iomanager::LoadVec(const std::string& fname)
 {
-  std::string path = loadDir + fname;
-  std::ifstream inData (path.c_str());
-  std::vector <double> output;
-  double insert;
-
-  while(inData){
-      inData >> insert;
-      output.push_back(insert);
+  VecView view(loadDir + fname);
+
+  return std::vector<double>(view.begin(), view.end());
+}
+
+VecView* Iomanager::MapVec(const std::string& fname)
+{
+  return new VecView(loadDir + fname);
+}
+
+bool Iomanager::Clone(const std::string& fname, const std::string& path)
+{
+  struct stat info;
+  int in = open((loadDir + fname).c_str(), O_RDONLY);
+
+  if (in < 0)
+    return false;
+  if (fstat(in, &info) != 0) {
+    close(in);
+    return false;
   }
 
-  inData.close();
-  output.pop_back();
+  int out = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    close(in);
+    return false;
+  }
 
-  return output;
+  bool done = false;
+#ifdef FICLONE
+  done = ioctl(out, FICLONE, in) == 0;
+#endif
+  off_t offset = 0;
+  while (!done) {
+    ssize_t sent = sendfile(out, in, &offset, info.st_size - offset);
+    if (sent <= 0)
+      break;
+    done = offset >= info.st_size;
+  }
+
+  close(in);
+
+  return close(out) == 0 && (done || info.st_size == 0);
+}
+
+VecView::VecView(const std::string& path)
+{
+  struct stat info;
+
+  opened = false;
+  base = NULL;
+  data = NULL;
+  size = 0;
+  count = 0;
+
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0 || fstat(fd, &info) != 0)
+    return;
+
+  opened = true;
+  size = info.st_size;
+  if (size == 0)
+    return;
+
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    opened = false;
+    return;
+  }
+  base = (char*)map;
+
+  const VecHeader *header = (const VecHeader*)base;
+  if (size >= sizeof(VecHeader) && memcmp(header->magic, vecMagic, sizeof(vecMagic)) == 0) {
+    count = std::min<uint64_t>(header->count, (size - sizeof(VecHeader))/sizeof(double));
+    data = (const double*)(base + sizeof(VecHeader));
+    return;
+  }
+
+  // Text: parsed from a NUL terminated copy of the mapping (strtod needs one)
+  std::string text(base, size);
+  const char *p = text.c_str();
+  char *next;
+
+  parsed.reserve(size/8);
+  while (true) {
+    double value = strtod(p, &next);
+    if (next == p)
+      break;
+    parsed.push_back(value);
+    p = next;
+  }
+
+  munmap(base, size);
+  base = NULL;
+  close(fd);
+  fd = -1;
+
+  count = parsed.size();
+  data = parsed.data();
+}
+
+VecView::~VecView()
+{
+  if (base)
+    munmap(base, size);
+  if (fd >= 0)
+    close(fd);
 }
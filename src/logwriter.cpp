@@ -0,0 +1,176 @@
+/*
+ *  logwriter.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <chrono>
+#include "include/logwriter.h"
+
+LogWriter::LogWriter(const std::string& path, LogFormat _format, int _blockSize, int _maxBlocks, double _period)
+  : file(path.c_str(), std::ofstream::out | std::ofstream::binary)
+{
+  format = _format;
+  blockSize = _blockSize;
+  maxBlocks = _maxBlocks;
+  period = _period;
+
+  current = NewBlock();
+  flush = false;
+  writing = false;
+  done = false;
+  dropped = 0;
+
+  writer = std::thread(&LogWriter::Loop, this);
+}
+
+LogWriter::~LogWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    done = true;
+  }
+  ready.notify_one();
+  writer.join();
+
+  delete current;
+  for (int i = 0; i < pool.size(); ++i)
+    delete pool[i];
+}
+
+std::string* LogWriter::NewBlock()
+{
+  std::string *block;
+
+  if (pool.empty()) {
+    block = new std::string;
+    block->reserve(blockSize);
+  }
+  else {
+    block = pool.front();
+    pool.pop_front();
+  }
+
+  return block;
+}
+
+void LogWriter::Write(const char *data, size_t size)
+{
+  size_t need = size + (format == BINARY_LOG ? sizeof(uint32_t) : 0);
+  bool full = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (!current->empty() && current->size() + need > blockSize) {
+      if (queue.size() >= maxBlocks) {
+        dropped++;
+        return;
+      }
+      queue.push_back(current);
+      current = NewBlock();
+      full = true;
+    }
+
+    if (format == BINARY_LOG) {
+      uint32_t frame = size;
+      current->append((const char*)&frame, sizeof(frame));
+    }
+    current->append(data, size);
+  }
+
+  if (full)
+    ready.notify_one();
+}
+
+void LogWriter::Flush()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  flush = true;
+  ready.notify_one();
+  idle.wait(lock, [this]{ return !flush && !writing; });
+}
+
+void LogWriter::Loop()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  std::deque<std::string*> blocks;
+
+  while (true) {
+    bool timeout = !ready.wait_for(lock, std::chrono::duration<double>(period),
+                                   [this]{ return !queue.empty() || flush || done; });
+
+    // Periodic, requested and final flushes take the partial block too
+    blocks.swap(queue);
+    if ((timeout || flush || done) && !current->empty()) {
+      blocks.push_back(current);
+      current = NewBlock();
+    }
+    bool finished = done, flushed = flush;
+    writing = true;
+
+    lock.unlock();
+    for (int i = 0; i < blocks.size(); ++i)
+      file.write(blocks[i]->data(), blocks[i]->size());
+    if (timeout || flushed || finished)
+      file.flush();
+    lock.lock();
+
+    for (int i = 0; i < blocks.size(); ++i) {
+      blocks[i]->clear();
+      pool.push_back(blocks[i]);
+    }
+    blocks.clear();
+    writing = false;
+    if (flushed)
+      flush = false;
+    idle.notify_all();
+
+    if (finished)
+      break;
+  }
+}
+
+int LogBuffer::overflow(int c)
+{
+  if (c != traits_type::eof())
+    line.push_back(c);
+
+  return traits_type::not_eof(c);
+}
+
+std::streamsize LogBuffer::xsputn(const char *s, std::streamsize n)
+{
+  line.append(s, n);
+
+  return n;
+}
+
+int LogBuffer::sync()
+{
+  if (!line.empty()) {
+    std::lock_guard<std::mutex> guard(*lock);
+    if (*writer)
+      (*writer)->Write(line.data(), line.size());
+  }
+  line.clear();
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ *  loopback.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "include/loopback.h"
+
+PoissonResponder::PoissonResponder(int *sizes, double *rates, int numPops, unsigned int seed)
+{
+  distribution = new distType(0,1);
+  generator = new genType(seed);
+  numberGenerator = new numGen(*generator, *distribution);
+
+  for (int i = 0; i < numPops; ++i)
+    for (int j = 0; j < sizes[i]; ++j)
+      rate.push_back(rates[i]);
+
+  next.resize(rate.size());
+  for (int i = 0; i < rate.size(); ++i)
+    next[i] = -log(1 - (*numberGenerator)())/rate[i];
+
+  received = 0;
+  emitted = 0;
+}
+
+PoissonResponder::~PoissonResponder()
+{
+  delete numberGenerator;
+  delete generator;
+  delete distribution;
+}
+
+void PoissonResponder::InsertEvent(double t, int id)
+{
+  received++;
+}
+
+void PoissonResponder::Respond(double t0, double t1, EventInput *handler)
+{
+  for (int i = 0; i < rate.size(); ++i) {
+    while (next[i] < t1) {
+      if (next[i] >= t0) {
+        handler->HandleEvent(next[i], i);
+        emitted++;
+      }
+      next[i] -= log(1 - (*numberGenerator)())/rate[i];
+    }
+  }
+}
+
+void PoissonResponder::Save(std::ostream& out)
+{
+  PutEngine(out, *generator);
+  Put(out, next);
+  Put(out, received);
+  Put(out, emitted);
+}
+
+void PoissonResponder::Load(std::istream& in)
+{
+  GetEngine(in, *generator);
+  Get(in, next);
+  Get(in, received);
+  Get(in, emitted);
+}
+
+LoopbackAgent::LoopbackAgent(Responder *_responder, Receiver *_inhandler, double TICK)
+{
+  responder = _responder;
+  inhandler = _inhandler;
+  outhandler = NULL;
+  tick = TICK;
+  t = 0;
+}
+
+LoopbackAgent::~LoopbackAgent() {}
+
+void LoopbackAgent::SetSender(Sender *_outhandler)
+{
+  outhandler = _outhandler;
+}
+
+double LoopbackAgent::Time()
+{
+  return t;
+}
+
+void LoopbackAgent::SendState(arma::vec& q, double tickt)
+{
+  outhandler->SendState(q, tickt);
+}
+
+void LoopbackAgent::SendReward(double reward, double tickt)
+{
+  outhandler->SendReward(reward, tickt);
+}
+
+double LoopbackAgent::Tick()
+{
+  responder->Respond(t, t + tick, inhandler);
+  t += tick;
+
+  return t;
+}
+
+double LoopbackAgent::GetAction(double tickt)
+{
+  return inhandler->GetAction(tickt);
+}
+
+double LoopbackAgent::GetDopa(double tickt)
+{
+  return inhandler->GetDopa(tickt);
+}
+
+double* LoopbackAgent::GetValue(double tickt, double reward)
+{
+  return inhandler->GetValue(tickt, reward);
+}
+
+void LoopbackAgent::Save(std::ostream& out)
+{
+  Put(out, t);
+  outhandler->Save(out);
+  inhandler->Save(out, t);
+  responder->Save(out);
+}
+
+void LoopbackAgent::Load(std::istream& in)
+{
+  Get(in, t);
+  outhandler->Load(in);
+  inhandler->Load(in);
+  responder->Load(in);
+}
@@ -29,6 +29,8 @@
 #include <math.h>
 #include <string>
 #include <string.h>
+#include <sstream>
+#include <fstream>
 
 // My Libraries
 #include <dynplot.hh>
@@ -44,6 +46,49 @@
 
 MPI::Intracomm comm;
 
+// Objects of one bee hosted by this rank
+struct Bee
+{
+  int id;                    // Bee number in the whole environment
+  Receiver *inhandler;
+  Sender *outhandler;
+  EventOffset *outport;      // Channel block of the bee
+  RateOffset *rateport;
+  MusicAgent *agent;
+  EpisodeRunner *runner;
+  Iomanager *manager;
+  Recorder *recorder;
+  std::string folder, checkpoint;
+};
+
+// Trace events of every rank gathered into one Chrome/Perfetto trace by rank 0
+static void SaveTrace(const std::string& fname)
+{
+  std::ostringstream events;
+  Profiler::WriteTrace(events);
+
+  std::string local(events.str());
+  int nProcs = comm.Get_size(),
+      size = local.size();
+  std::vector<int> sizes(nProcs), offsets(nProcs, 0);
+
+  comm.Gather(&size, 1, MPI::INT, &sizes[0], 1, MPI::INT, 0);
+  for (int i = 1; i < nProcs; ++i)
+    offsets[i] = offsets[i-1] + sizes[i-1];
+
+  std::vector<char> all(offsets[nProcs-1] + sizes[nProcs-1] + 1);
+  comm.Gatherv(local.data(), size, MPI::CHAR, &all[0], &sizes[0], &offsets[0], MPI::CHAR, 0);
+
+  if (comm.Get_rank() != 0)
+    return;
+
+  std::ofstream out(fname.c_str());
+  out << "{\"traceEvents\": [\n";
+  for (int i = 0; i < nProcs; ++i)
+    out << (i ? ",\n" : "") << std::string(&all[offsets[i]], sizes[i]);
+  out << "\n]}" << std::endl;
+}
+
 int main(int argc, char **argv)
 {
 /*======================================================SETUP PHASE=======================================================*/
@@ -54,10 +99,8 @@ int main(int argc, char **argv)
 
     const double pi = 3.1415926535897;
 
-    arma::vec q,
-              q0,
-              q_desired(12, arma::fill::zeros),
-              u(4, arma::fill::zeros);
+    arma::vec q0,
+              q_desired(12, arma::fill::zeros);
 
     q0 = { 0.2, -0.2,    0,	 	// Angular Position (Body Attached)
              0,    0,    0, 	// Angular Velocity (Body Attached) -1,0,1
@@ -66,17 +109,8 @@ int main(int argc, char **argv)
 
     q_desired(8) = 0.08;
 
-    q = q0;
-
-    double dynFreq = 1000, dynStep = 1/dynFreq,
-           maxRew = 50, sigma = 3.0,
-           reward = maxRew/2*cos(q(0)) +
-                    maxRew*std::exp(-std::pow(q(3),2)/(2*std::pow(sigma,2))) - maxRew/2;
-
-
-    // Objects Creation
-    Robobee bee(q, dynFreq);     // ROBOBEE
-    Controller ctr(q_desired);    // Controller
+    double dynFreq = 1000,
+           maxRew = 50, sigma = 3.0;
 
 /*===========================
 |   MUSIC Agent Connection  |
@@ -92,32 +126,86 @@ int main(int argc, char **argv)
     MUSIC::EventInputPort *indata = setup->publishEventInput("p_in");
     MUSIC::EventOutputPort *outdata = setup->publishEventOutput("p_out");
 
+    // Rate coded input: place cell and reward rates go through p_rates (same
+    // channels as p_out) and the agent draws the Poisson spikes itself
+    bool RATES = false;
+    MUSIC::ContOutputPort *ratedata = RATES ? setup->publishContOutput("p_rates") : NULL;
+
+    // Without an agent on p_rates the spikes still go out as events
+    bool noRates = RATES && !ratedata->isConnected();
+    if (noRates)
+      RATES = false;
+
     // Get number of processes and rank processor
     comm = setup->communicator();
     int nProcs = comm.Get_size();
     int rank = comm.Get_rank();
 
+    // Bees in the environment, each one owns a contiguous block of width/nBees
+    // output and input channels (the agent side must serve as many networks)
+    int nBees = 1;
+
+    // With more processes than bees, groups of ranksPerBee processes share a
+    // bee: all of them integrate its plant, the first one sends its place cells
+    // and each decodes a share of its readout channels (partial sums reduced
+    // once per tick, so every replica applies the same policy)
+    int ranksPerBee = nProcs > nBees ? nProcs / nBees : 1,
+        nGroups = nProcs / ranksPerBee,
+        group = rank / ranksPerBee,
+        member = rank % ranksPerBee;
+    bool leader = member == 0;
+
     // Figure out how many input/output channels we have
-    int width[2], firstId[2], nLocal[2], rest;
+    int width[2], beeWidth[2], firstId[2], nLocal[2], firstBee, nBeesLocal, rest;
     width[0] = outdata->width();
     width[1] = indata->width();
+    if (width[0] % nBees != 0 || width[1] % nBees != 0) {
+        std::cerr << "Port widths " << width[0] << "/" << width[1] << " are not a multiple of " << nBees << " bees" << std::endl;
+        comm.Abort(1);
+    }
 
-    // Divide channels evenly over the number of processes
+    // Divide bees evenly over the groups of processes
+    nBeesLocal = nBees / nGroups;
+    rest = nBees % nGroups;
+    firstBee = nBeesLocal * group;
+    if (group < rest) {
+        firstBee += group;
+        nBeesLocal += 1;
+    } else
+    firstBee += rest;
+    if (group >= nGroups) {
+        firstBee = nBees;
+        nBeesLocal = 0;
+    }
+
+    // Channels of the local bees
     for (int i = 0; i < 2; ++i)
     {
-        nLocal[i] = width[i] / nProcs;
-        rest = width[i] % nProcs;
-        firstId[i] = nLocal[i] * rank;
-        if (rank < rest) {
-            firstId[i] += rank;
-            nLocal[i] += 1;
+        beeWidth[i] = width[i] / nBees;
+        firstId[i] = beeWidth[i] * firstBee;
+        nLocal[i] = beeWidth[i] * nBeesLocal;
+    }
+
+    // Readout channels of a shared bee divided evenly over its ranks
+    int partFirst = 0, partCount = beeWidth[1];
+    if (ranksPerBee > 1) {
+        partCount = beeWidth[1] / ranksPerBee;
+        rest = beeWidth[1] % ranksPerBee;
+        partFirst = partCount * member;
+        if (member < rest) {
+            partFirst += member;
+            partCount += 1;
         } else
-        firstId[i] += rest;
+        partFirst += rest;
+
+        firstId[1] += partFirst;
+        nLocal[1] = nBeesLocal > 0 ? partCount : 0;
+        if (!leader)
+            nLocal[0] = 0;
     }
 
-    int idx[nLocal[0]];
-    for (int i = 0; i < nLocal[0]; ++i)
-        idx[i] = firstId[0] + i;
+    MPI::Intracomm beeComm = comm.Split(group, member);
+    MpiPartialSum *partial = ranksPerBee > 1 ? new MpiPartialSum(beeComm) : NULL;
 
     // Create an index based on the rank channel asignment above
     MUSIC::LinearIndex outindex(firstId[0], nLocal[0]);
@@ -128,19 +216,7 @@ int main(int argc, char **argv)
 
     double value_param[] = {1.5, -100.0, 1.0},       // [A_critic, b_critic, tau_r]
            policy_param[] = {3e-6, -3e-6},          // [F_max, F_min]
-           dopa_param[] = {1, 0},                   // [A_dopa, b_dopa]
-           *value,
-           valueFunction = value_param[1],
-           tdError = 0,
-           policy = 0,
-           dopaActivity = 0;
-
-    // Generate an instance of Receiver
-    Receiver *inhandler = new Receiver(pops_size, sizeof(pops_size)/sizeof(pops_size[0]));
-
-    inhandler->SetCritic(0, value_param);
-    inhandler->SetActor(1, policy_param);
-    inhandler->SetDopa(2, dopa_param);
+           dopa_param[] = {1, 0};                   // [A_dopa, b_dopa]
 
     /* NETWORK INPUT */
     double max_psg = 1000,            // Max rate Poisson process for place cells
@@ -151,34 +227,61 @@ int main(int argc, char **argv)
 
     bool types[] = {true, false};    // true->angle false->anyother
 
-    Sender *outhandler = new Sender(outdata, TICK);
-    outhandler->CreatePlaceCells(2, idState, resState, types, ranges, max_psg);
+    MusicEventOutput *outport = new MusicEventOutput(outdata);
+    EventDemux *demux = new EventDemux(beeWidth[1] * firstBee, beeWidth[1]);
+    MusicRateOutput *rateport = RATES ? new MusicRateOutput(ratedata, firstId[0], nLocal[0]) : NULL;
+
+    // Objects Creation: Receiver, Sender and closed loop (ROBOBEE, Controller) of every local bee
+    std::vector<Bee> bees(nBeesLocal);
+    for (int b = 0; b < nBeesLocal; ++b) {
+      Bee& bee = bees[b];
+      bee.id = firstBee + b;
+
+      bee.inhandler = new Receiver(pops_size, sizeof(pops_size)/sizeof(pops_size[0]));
+      bee.inhandler->SetCritic(0, value_param);
+      bee.inhandler->SetActor(1, policy_param);
+      bee.inhandler->SetDopa(2, dopa_param);
+      demux->Add(bee.inhandler);
+      if (partial)
+        bee.inhandler->SetPartial(partFirst, partCount, partial);
+
+      bee.outport = NULL;
+      bee.rateport = NULL;
+      bee.outhandler = NULL;
+      if (leader) {
+        bee.outport = new EventOffset(outport, firstId[0] + b*beeWidth[0]);
+        bee.outhandler = new Sender(bee.outport, TICK);
+        bee.outhandler->CreatePlaceCells(2, idState, resState, types, ranges, max_psg);
+        if (rateport) {
+          bee.rateport = new RateOffset(rateport, firstId[0] + b*beeWidth[0]);
+          bee.outhandler->SetRateOutput(bee.rateport, true, true);
+        }
+      }
+
+      bee.runner = new EpisodeRunner(q0, q_desired, dynFreq, TICK);
+      bee.runner->SetReward(maxRew, sigma);
+      bee.runner->SetBounds(2*abs(ranges[0]), abs(ranges[1]));
+    }
 
     // Mapping Input/Output Port
     outdata->map(&outindex, MUSIC::Index::GLOBAL);
-    indata->map(&inindex, inhandler, IN_LATENCY, 1);
+    MusicEventInput *inport = new MusicEventInput(demux);
+    indata->map(&inindex, inport, IN_LATENCY, 1);
 
 /*==================
 |   OPENGL         |
 ==================*/
     bool ANIMATE = false, REC = false;
     int length = 800, height = 600;
-	  double frameRate = 0.01;
-
-	  Display* Frame = new Display("Hello World!", length, height);
-	  Camera *Cam = new Camera(glm::vec3(-0.3,0.2,0.2), glm::vec3(0,0,0), glm::vec3(0,1,0));
-	  Light *Lamp = new Light(glm::vec3(2,1,5));
-	  Shader *myShader = new Shader("../graphic/vertex.glsl", "../graphic/fragment.glsl");
-	  Model *Base = new Model("../graphic/","base");
-	  Model *Robot = new Model("../graphic/","robobee");
-
-    if (!ANIMATE){
-      delete Frame;
-      delete Cam;
-      delete Lamp;
-      delete myShader;
-      delete Base;
-      delete Robot;
+	  double frameRate = 100;
+
+    // Rendering runs on its own thread, the simulation only publishes the pose
+    // of the first local bee. REC without ANIMATE renders headless
+    Renderer *Render = NULL;
+    FrameCapture *Capture = NULL;
+    if ((ANIMATE || REC) && nBeesLocal > 0 && leader) {
+      Render = new Renderer("Hello World!", length, height, frameRate, "../graphic/");
+      Render->SetHeadless(!ANIMATE);
     }
 
 /*==================
@@ -198,26 +301,105 @@ int main(int argc, char **argv)
         std::cout << "Success" << "\n";
     }
 
-    double lenghtVecs = dynFreq*simt + 1;
-    arma::vec timeSim(lenghtVecs, 1);
-
-    // Agent
-    enum{VALUEFUN,POLICY,DOPA};
-    arma::mat network(3, lenghtVecs);
-
-    // Environment
-    enum {REWARD,TDERROR};
-    arma::mat environment(2, lenghtVecs);
-    arma::mat state(q.size(), lenghtVecs),
-              control(u.size(),lenghtVecs);
-
     // OpenGL frames
-    if (REC)
-      Frame->SetRecorder(folder + "flight.mp4");
+    if (REC && Render) {
+      Capture = new FrameCapture(folder + "flight.mp4", length, height, frameRate);
+      Render->SetCapture(Capture);
+    }
 
     Iomanager manager("BeeBrain/", folder);
     manager.SetStream("trials.dat", "out");
 
+    double levels[] = {10};          // Overview level [Hz] next to the full rate streams
+
+    // Readout and encoding overlapped with the plant steps; the policy then
+    // lags one TICK on top of IN_LATENCY. Only with one bee per rank: the
+    // workers of several bees would share the output port and Traffic
+    bool PIPELINE = false;
+    if (PIPELINE && (nBeesLocal > 1 || ranksPerBee > 1)) {
+      manager.Print() << "Pipelined mode needs one unshared bee per rank, running serial" << std::endl;
+      PIPELINE = false;
+    }
+    if (noRates)
+      manager.Print() << "p_rates is not connected, sending events on p_out" << std::endl;
+
+    // Trial log, recording and periodic snapshot (picked up by the next run
+    // after a crash) of every bee, in its own folder when there are several.
+    // A shared bee is recorded by its first rank only and has no snapshot
+    // (each rank holds a different share of the readout spikes); its
+    // collective readout stays on the main thread
+    for (int b = 0; b < nBeesLocal; ++b) {
+      Bee& bee = bees[b];
+      bee.manager = NULL;
+      bee.recorder = NULL;
+      bee.runner->SetPipelined(PIPELINE);
+      if (!leader)
+        continue;
+
+      if (nBees > 1) {
+        bee.folder = folder + "bee" + std::to_string(bee.id) + "/";
+        bee.checkpoint = "Simulations/checkpoint." + std::to_string(bee.id) + ".bin";
+        boost::filesystem::create_directory(bee.folder);
+        bee.manager = new Iomanager("BeeBrain/", bee.folder);
+        bee.manager->SetStream("trials.dat", "out");
+      }
+      else {
+        bee.folder = folder;
+        bee.checkpoint = "Simulations/checkpoint.bin";
+        bee.manager = &manager;
+      }
+      bee.runner->SetLog(bee.manager);
+
+      bee.recorder = new Recorder(bee.folder);
+      bee.recorder->SetLevels(levels, 1);
+      bee.runner->SetRecorder(bee.recorder);
+
+      if (ranksPerBee == 1)
+        bee.runner->SetCheckpoint(bee.checkpoint, 600);
+      else
+        bee.checkpoint.clear();
+    }
+
+    // Per tick timeline of every rank (trace.json, chrome://tracing or
+    // ui.perfetto.dev), needs ./configure --enable-profile
+    bool TRACE = false;
+#ifndef ROBOBEE_PROFILE
+    if (TRACE) {
+      manager.Print() << "TRACE needs ./configure --enable-profile, no trace written" << std::endl;
+      TRACE = false;
+    }
+#endif
+
+    // Hardware-in-the-loop pacing: 1 kHz plant and TICK neural loop against
+    // the wall clock, deadline misses and jitter in the log (pinCpu < 0 -> no pinning)
+    bool REALTIME = false;
+    int pinCpu = -1;
+    Pacer plantPacer("plant", 1/dynFreq), neuralPacer("neural", TICK);
+    if (REALTIME && nBeesLocal > 0)
+      bees[0].runner->SetPacing(NULL, &neuralPacer);
+
+    // Link traffic of this rank: events per channel group, bytes, tick wait
+    // and spike age per tick in traffic[.<rank>].bin, summary in the log
+    bool TRAFFIC = false;
+    Traffic traffic;
+    Recorder *trafficLog = NULL;
+    if (TRAFFIC) {
+      for (int b = 0; b < nBeesLocal; ++b) {
+        bees[b].inhandler->SetTraffic(&traffic);
+        if (bees[b].outhandler)
+          bees[b].outhandler->SetTraffic(&traffic);
+      }
+      trafficLog = new Recorder(folder);
+      traffic.SetLog(trafficLog, nProcs > 1 ? "traffic." + std::to_string(rank) : "traffic", 1/TICK);
+    }
+
+    // Live monitoring of the first local bee: ./monitor <name>
+    Telemetry telemetry;
+    if (nBeesLocal > 0 && leader) {
+      bees[0].runner->SetTelemetry(&telemetry);
+      manager.Print() << "Telemetry " << telemetry.Name() << std::endl;
+    }
+
 /*========================================================================================================================*/
 
 
@@ -226,208 +408,111 @@ int main(int argc, char **argv)
     // Create runtime object -> start runtime phase (end setup phase)
     MUSIC::Runtime *runtime = new MUSIC::Runtime(setup, TICK);
 
-    // Initialize
-    int iter = 0,
-        prevStep = 0,
-        trials = 0;
-
-    double tickt = runtime->time(), // Neuro-Controller/MUSIC TICK time
-           dynTime = 0,             // Simulation time
-           loadDopa = 1.0,          // Dopaminergic neurons loading time
-           startSim = 2.0,          // Simulation start time
-           punishTime = -1.0,        // Time of punish deliverying
-           clockStop = 1.0,         // Resting time between trials
-           trialTime = 0,           // Record duration of each trial
-           prevRew = 0,
-           robotPos = 0,
-           thetaCheck = 0,
-           omegaCheck = 0,
-           cageBound = std::pow(q_desired(8),2),
-           thetaBound = 2*abs(ranges[0]),
-           omegaBound = abs(ranges[1]),
-           controlRate = 0.0,
-           cumulativeRew = 0.0,
-           succTrial = 0;
-
-    bool netControl = true;
-
-    arma::vec prevState(12, arma::fill::zeros),
-              crashState(12, arma::fill::zeros),
-              falseState(12, arma::fill::zeros);
+    // One runtime tick per TICK serves all the local bees
+    MusicAgent clock(runtime, NULL, NULL);
+    Swarm swarm(&clock, simt);
+    if (TRAFFIC)
+      clock.SetTraffic(&traffic);
+    if (REALTIME)
+      swarm.SetPacing(&plantPacer);
 
     // Simulation Loop
     manager.Print() << "Simulation start time " << timeInfo->tm_hour << ":" << timeInfo->tm_min << ":" << timeInfo->tm_sec << std::endl;
-    manager.Print() << std::setw(15) << "Trial"
-                    << std::setw(15) << "Start Time"
-                    << std::setw(15) << "End Time"
-                    << std::setw(15) << "Trial Time"
-                    << std::setw(15) << "Avg Reward"
-                    << std::setw(15) << "Control Rate" << std::endl;
-    while (tickt < simt) {
-
-        // Real Time Robot Motion with 100Hz framerate
-        if (ANIMATE && std::abs(remainder(tickt,frameRate)) < 0.00001){
-          Frame->Clear(0.0f, 0.1f, 0.15f, 1.0f);
-			    myShader->Bind();
-			    Robot->SetPos( glm::vec3( q(7), q(8), q(6) ) );
-			    Robot->SetRot( glm::vec3( q(1), q(2), q(0) ) );
-			    myShader->Update(*Robot, *Cam, *Lamp);
-			    Robot->Draw();
-			    myShader->Update(*Base, *Cam, *Lamp);
-			    Base->Draw();
-			    Frame->Update();
-        }
+    if (TRACE)
+      Profiler::StartTrace(rank);
+    if (Render)
+      Render->Start();
+
+    // Pinned once the render thread exists, so that it does not inherit the CPU
+    if (REALTIME && pinCpu >= 0 && !Pacer::PinThread(pinCpu))
+      manager.Print() << "Cannot pin to CPU " << pinCpu << std::endl;
+
+    for (int b = 0; b < nBeesLocal; ++b) {
+      Bee& bee = bees[b];
+      bee.agent = new MusicAgent(runtime, bee.outhandler, bee.inhandler, false);
+      bee.runner->Start(bee.agent, simt);
+      if (!bee.checkpoint.empty() && boost::filesystem::exists(bee.checkpoint)) {
+        if (bee.runner->Restore(bee.checkpoint))
+          manager.Print() << "Restored " << bee.checkpoint << " at " << bee.runner->Time() << " s" << std::endl;
+        else
+          manager.Print() << "Could not restore " << bee.checkpoint << " (truncated or another layout), starting over" << std::endl;
+      }
+      if (!swarm.Add(bee.runner)) {
+        manager.Print() << "Bee " << bee.id << " at " << bee.runner->Time() << " s is out of step with the swarm"
+                        << " (remove the stale checkpoints to start over)" << std::endl;
+        manager.Flush();
+        comm.Abort(1);
+      }
+    }
 
-        // 1000Hz Classical Controller calculates 3 control torques
-        u = arma::join_vert(ctr.AltitudeControl(q), ctr.DampingControl(q));
-
-        // 100Hz Neural Controller
-        if(dynTime >= TICK && std::abs(remainder(dynTime,TICK)) < 0.00001)
-        {
-          prevStep = tickt/dynStep;
-          prevState = state.col(prevStep);
-          prevRew =  environment(REWARD, prevStep);
-          if (tickt > startSim)
-            cumulativeRew += prevRew;
-
-          if (dynTime >= loadDopa)
-            outhandler->SendState(prevState, tickt); // falseState
-
-          // Dopaminergic Neurons Stimulation
-          if (tdError >= 1000.0)
-            tdError = 1000.0;
-          else if (tdError <= -1000.0)
-            tdError = -1000.0;
-          outhandler->SendReward(tdError, tickt); // 0
-
-          runtime->tick();  // Music Communication: spikes are sent and received here
-          tickt = runtime->time();
-
-          policy = inhandler->GetAction(tickt);        // Policy
-          dopaActivity = inhandler->GetDopa(tickt);    // Dopaminergi neurons activity
-          value = inhandler->GetValue(tickt, prevRew); // Value Function and TD-error
-          valueFunction = value[0];
-          tdError = value[1];
-
-          if (dynTime > punishTime + TICK && dynTime <= startSim)
-            tdError = 0;
-        }
+    while (swarm.Running()) {
 
-        // Recording
-        timeSim(iter) = dynTime;
-        state.col(iter) = q;
-        control.col(iter) = u;
-        network(VALUEFUN, iter) = valueFunction;
-        network(POLICY, iter) = policy;
-        network(DOPA, iter) = dopaActivity;
-        environment(REWARD, iter) = reward;
-        environment(TDERROR, iter) = tdError;
-
-        // Activate Neural Controller
-        if (netControl)
-          u(1) = controlRate*u(1) + policy;
-
-        // Environment (RoboBee) generates the new state and reward
-        q = bee.BeeDynamics(u);
-        reward = maxRew/2*cos(q(0)) +
-                 maxRew*std::exp(-std::pow(q(3),2)/(2*std::pow(sigma,2))) - maxRew/2;
-
-        // Check Boundaries
-        if (dynTime >= startSim){
-            robotPos = std::pow(q(6),2)/8 + std::pow(q(7),2)/8 + std::pow(q(8)-q_desired(8),2);
-            thetaCheck = std::abs(q(0));
-            omegaCheck = std::abs(q(3));
-        }
-        // Crashing condition
-        if (thetaCheck > thetaBound || omegaCheck > omegaBound || robotPos > cageBound){
-          crashState = state.col(tickt/dynStep);
-          trialTime = dynTime - startSim;
-          manager.Print() << std::setw(15) << trials
-                          << std::setw(15) << startSim
-                          << std::setw(15) << dynTime
-                          << std::setw(15) << trialTime
-                          << std::setw(15) << controlRate
-                          << std::setw(15) << cumulativeRew/trialTime << std::endl;
-          if (trialTime < 1.0)
-            controlRate += 0.01;
-          punishTime = tickt + TICK;
-          startSim = punishTime + clockStop;
-          trials++;
-          thetaCheck = 0;
-          omegaCheck = 0;
-          robotPos = 0;
-          cumulativeRew = 0;
-        }
-        else if (dynTime - startSim >= 10.0 && netControl) {
-          succTrial += 1;
-          // controlRate -= 0.01;
-          trialTime = dynTime - startSim;
-          manager.Print() << std::setw(15) << trials
-                          << std::setw(15) << startSim
-                          << std::setw(15) << dynTime
-                          << std::setw(15) << trialTime
-                          << std::setw(15) << controlRate
-                          << std::setw(15) << cumulativeRew/trialTime << std::endl;
-          startSim = tickt + TICK + clockStop;
-          trials++;
-          cumulativeRew = 0;
+        // Real Time Robot Motion, drawn by the render thread at frameRate
+        if (Render) {
+          PROFILE_SCOPE("render publish");
+          Render->Publish(bees[0].runner->State(), bees[0].runner->Time());
         }
 
-        // Stop Simulation
-        if (dynTime <= punishTime + TICK){
-          q = crashState;
-          reward = -50;
-          bee.InitRobot(q);
-          ctr.Reset();
-        }
-        else if (dynTime > punishTime + TICK && dynTime <= startSim) {
-          q = q0;
-          bee.InitRobot(q);
-          ctr.Reset();
+        if (!swarm.Step()) {
+          manager.Print() << "Bees out of lockstep at " << bees[0].runner->Time() << " s" << std::endl;
+          manager.Flush();
+          comm.Abort(1);
         }
-
-        // Increment Counters
-        dynTime += dynStep;
-        iter++;
     }
 
-    // End runtime phase
-    runtime->finalize();
+    // End runtime phase (the trace is gathered while MPI is still up)
+    if (Render)
+      Render->Stop();
+    if (TRACE)
+      SaveTrace(folder + "trace.json");
+    swarm.Finalize();
+    for (int b = 0; b < nBeesLocal; ++b)
+      if (!bees[b].checkpoint.empty())
+        boost::filesystem::remove(bees[b].checkpoint);
 
     time (&timer);
     timeInfo = localtime(&timer);
     manager.Print() << "Simulation end time " << timeInfo->tm_hour << ":" << timeInfo->tm_min << ":" << timeInfo->tm_sec << std::endl;
-    manager.Print() << "Control Rate: " << controlRate << std::endl;
-    manager.Print() << "Successful trials: " << succTrial << std::endl;
+    for (int b = 0; b < nBeesLocal; ++b) {
+      if (nBees > 1)
+        manager.Print() << "Bee " << bees[b].id << std::endl;
+      manager.Print() << "Control Rate: " << bees[b].runner->ControlRate() << std::endl;
+      manager.Print() << "Successful trials: " << bees[b].runner->SuccTrials() << std::endl;
+    }
+    if (REALTIME) {
+      plantPacer.Report(manager.Print());
+      neuralPacer.Report(manager.Print());
+    }
+    if (TRAFFIC) {
+      trafficLog->Close();
+      traffic.Report(manager.Print());
+    }
+#ifdef ROBOBEE_PROFILE
+    Profiler::Save(folder + "profile.dat");
+#endif
+    if (Capture) {
+      Capture->Close();
+      manager.Print() << "Frames captured: " << Capture->Captured()
+                      << " dropped: " << Capture->Dropped()
+                      << " late: " << Render->Late() << std::endl;
+    }
 /*========================================================================================================================*/
 
 
 
 /*=====================================================SAVING PHASE=======================================================*/
 
-
-    state.save(folder + "state.dat",arma::raw_ascii); // arma::raw_ascii
-    control.save(folder + "control.dat",arma::raw_ascii);
-    timeSim.save(folder + "simtime.dat",arma::raw_ascii);
-    network.save(folder + "network.dat",arma::raw_ascii);
-    environment.save(folder + "environment.dat",arma::raw_ascii);
-
-    arma::mat netParams;
-    netParams.load("BeeBrain/pCellsIDs.dat");
-    netParams.save(netFolder + "pCellsIDs.dat",arma::raw_ascii);
-    netParams.clear();
-    netParams.load("BeeBrain/criticIDs.dat");
-    netParams.save(netFolder + "criticIDs.dat",arma::raw_ascii);
-    netParams.clear();
-    netParams.load("BeeBrain/actorIDs.dat");
-    netParams.save(netFolder + "actorIDs.dat",arma::raw_ascii);
-    netParams.clear();
-    netParams.load("BeeBrain/connToCritic.dat");
-    netParams.save(netFolder + "connToCritic.dat",arma::raw_ascii);
-    netParams.clear();
-    netParams.load("BeeBrain/connToActor.dat");
-    netParams.save(netFolder + "connToActor.dat",arma::raw_ascii);
-    netParams.clear();
+    // Network files cloned into the run folder, the connections also in
+    // binary for the analysis, always converted from the text just written
+    // (a .bin in BeeBrain/ may be left over from an earlier run)
+    std::string netFiles[] = {"pCellsIDs.dat", "criticIDs.dat", "actorIDs.dat", "connToCritic.dat", "connToActor.dat"},
+                connFiles[] = {"connToCritic", "connToActor"};
+    if (rank == 0) {
+      for (int i = 0; i < 5; ++i)
+        manager.Clone(netFiles[i], netFolder + netFiles[i]);
+      for (int i = 0; i < 2; ++i)
+        ConvertConnections(netFolder + connFiles[i] + ".dat", netFolder + connFiles[i] + ".bin");
+    }
 
 /*========================================================================================================================*/
 
@@ -435,19 +520,30 @@ int main(int argc, char **argv)
 
 /*====================================================CLEANING PHASE======================================================*/
 
+    for (int b = 0; b < nBeesLocal; ++b) {
+      Bee& bee = bees[b];
+      delete bee.runner;
+      delete bee.agent;
+      delete bee.recorder;
+      if (bee.manager != &manager)
+        delete bee.manager;
+      delete bee.inhandler;
+      delete bee.outhandler;
+      delete bee.outport;
+      delete bee.rateport;
+    }
+
     delete runtime;
-    delete inhandler;
-    delete outhandler;
+    delete inport;
+    delete demux;
+    delete outport;
+    delete rateport;
+    delete partial;
+    delete trafficLog;
 
     // OpenGL
-    if (ANIMATE){
-      delete Frame;
-      delete Cam;
-      delete Lamp;
-      delete myShader;
-      delete Base;
-      delete Robot;
-    }
+    delete Render;
+    delete Capture;
 
 /*========================================================================================================================*/
 }
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <dirent.h>
+#include "include/telemetry.h"
+
+// Live view of running simulations (shared memory telemetry)
+//   monitor                  list the runs on this host
+//   monitor name             latest sample
+//   monitor name -f [every]  follow, printing one sample out of every
+
+static void PrintHeader()
+{
+  std::cout << std::setw(10) << "time"
+            << std::setw(12) << "theta"
+            << std::setw(12) << "omega"
+            << std::setw(12) << "z"
+            << std::setw(12) << "lift"
+            << std::setw(12) << "reward"
+            << std::setw(12) << "tdError"
+            << std::setw(12) << "value"
+            << std::setw(12) << "policy"
+            << std::setw(12) << "dopa"
+            << std::setw(8) << "trials" << std::endl;
+}
+
+static void Print(const TelemetrySample& s)
+{
+  std::cout << std::setw(10) << s.t
+            << std::setw(12) << s.q[0]
+            << std::setw(12) << s.q[3]
+            << std::setw(12) << s.q[8]
+            << std::setw(12) << s.u[0]
+            << std::setw(12) << s.reward
+            << std::setw(12) << s.tdError
+            << std::setw(12) << s.value
+            << std::setw(12) << s.policy
+            << std::setw(12) << s.dopa
+            << std::setw(8) << s.trials << std::endl;
+}
+
+int main(int argc, char const *argv[]) {
+  if (argc < 2) {
+    DIR *dir = opendir("/dev/shm");
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir))) {
+      if (strncmp(entry->d_name, "robobee.", 8) != 0)
+        continue;
+      TelemetryReader reader(std::string("/") + entry->d_name);
+      if (reader.IsOpen())
+        std::cout << "/" << entry->d_name << "  pid " << reader.Pid()
+                  << "  samples " << reader.Written() << std::endl;
+    }
+    if (dir)
+      closedir(dir);
+    return 0;
+  }
+
+  std::string name(argv[1]);
+  if (name[0] != '/')
+    name = "/" + name;
+
+  TelemetryReader reader(name);
+  if (!reader.IsOpen()) {
+    std::cout << name << ": no telemetry" << std::endl;
+    return 1;
+  }
+
+  TelemetrySample sample;
+  bool follow = argc > 2 && std::string(argv[2]) == "-f";
+  long every = argc > 3 ? std::atol(argv[3]) : 100;
+  if (every < 1)
+    every = 1;
+
+  PrintHeader();
+  if (!follow) {
+    uint64_t n = reader.Written();
+    while (n > reader.Oldest() && !reader.Read(n - 1, sample))
+      n--;
+    if (n > reader.Oldest())
+      Print(sample);
+    return 0;
+  }
+
+  // Start from the latest sample, skip what the ring already overwrote
+  uint64_t next = reader.Written();
+  next -= next % every;
+  while (true) {
+    uint64_t written = reader.Written();
+    if (next < reader.Oldest())
+      next = reader.Oldest() + every - reader.Oldest() % every;
+
+    for (; next < written; next += every)
+      if (reader.Read(next, sample))
+        Print(sample);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ *  musicagent.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <chrono>
+#include "include/musicagent.h"
+
+MusicAgent::MusicAgent(MUSIC::Runtime *_runtime, Sender *_outhandler, Receiver *_inhandler, bool _ticks)
+{
+  runtime = _runtime;
+  outhandler = _outhandler;
+  inhandler = _inhandler;
+  ticks = _ticks;
+  traffic = NULL;
+}
+
+MusicAgent::~MusicAgent() {}
+
+double MusicAgent::Time()
+{
+  return runtime->time();
+}
+
+void MusicAgent::SendState(arma::vec& q, double tickt)
+{
+  if (outhandler)
+    outhandler->SendState(q, tickt);
+}
+
+void MusicAgent::SendReward(double reward, double tickt)
+{
+  if (outhandler)
+    outhandler->SendReward(reward, tickt);
+}
+
+double MusicAgent::Tick()
+{
+  if (ticks && traffic) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runtime->tick();
+    traffic->EndTick(runtime->time(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  else if (ticks)
+    runtime->tick();  // Music Communication: spikes are sent and received here
+
+  return runtime->time();
+}
+
+double MusicAgent::GetAction(double tickt)
+{
+  return inhandler->GetAction(tickt);
+}
+
+double MusicAgent::GetDopa(double tickt)
+{
+  return inhandler->GetDopa(tickt);
+}
+
+double* MusicAgent::GetValue(double tickt, double reward)
+{
+  return inhandler->GetValue(tickt, reward);
+}
+
+void MusicAgent::Finalize()
+{
+  if (ticks)
+    runtime->finalize();
+}
+
+void MusicAgent::SetTraffic(Traffic *_traffic)
+{
+  traffic = _traffic;
+}
+
+void MusicAgent::Save(std::ostream& out)
+{
+  double t = runtime->time();
+
+  Put(out, t);
+  if (outhandler)
+    outhandler->Save(out);
+  inhandler->Save(out, t);
+}
+
+void MusicAgent::Load(std::istream& in)
+{
+  double t;
+
+  // A new runtime starts its clock again: move the stored spikes with it
+  Get(in, t);
+  if (outhandler)
+    outhandler->Load(in);
+  inhandler->Load(in, runtime->time() - t);
+}
@@ -0,0 +1,150 @@
+/*
+ *  pacer.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <iomanip>
+#include <algorithm>
+#include "include/pacer.h"
+#include "include/profiler.h"
+
+Pacer::Pacer(const std::string& _name, double _period)
+  : jitterBins(Profiler::NumBuckets, 0)
+{
+  name = _name;
+  period = _period*1e9;
+  release = 0;
+
+  jobs = 0;
+  misses = 0;
+  resyncs = 0;
+  jitterSum = 0;
+  jitterMax = 0;
+  overrunMax = 0;
+}
+
+Pacer::~Pacer() {}
+
+int64_t Pacer::Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+void Pacer::Start()
+{
+  release = Now();
+}
+
+void Pacer::AddJitter(int64_t ns)
+{
+  ns = std::max<int64_t>(ns, 0);
+  jitterSum += ns;
+  jitterMax = std::max(jitterMax, ns);
+  jitterBins[Profiler::Bucket(ns)]++;
+}
+
+void Pacer::Wait()
+{
+  int64_t deadline = release + period,
+          now = Now();
+
+  jobs++;
+  if (now > deadline) {
+    misses++;
+    overrunMax = std::max(overrunMax, now - deadline);
+
+    // More than a period behind: restart the schedule instead of bursting
+    if (now - deadline > period) {
+      resyncs++;
+      release = now;
+      return;
+    }
+  }
+  else {
+    timespec ts;
+    ts.tv_sec = deadline/1000000000;
+    ts.tv_nsec = deadline%1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+    now = Now();
+  }
+
+  AddJitter(now - deadline);
+  release = deadline;
+}
+
+void Pacer::Release()
+{
+  int64_t now = Now();
+
+  if (jobs > 0)
+    AddJitter(now - (release + period));
+  release = now;
+}
+
+void Pacer::Complete()
+{
+  int64_t response = Now() - release;
+
+  jobs++;
+  if (response > period) {
+    misses++;
+    overrunMax = std::max(overrunMax, response - period);
+  }
+}
+
+void Pacer::Report(std::ostream& out)
+{
+  long samples = 0, p99 = 0;
+  for (int b = 0; b < jitterBins.size(); ++b)
+    samples += jitterBins[b];
+  for (long b = 0, seen = 0; b < jitterBins.size() && samples > 0; ++b) {
+    seen += jitterBins[b];
+    if (seen >= 0.99*samples) {
+      p99 = std::min<int64_t>(Profiler::BucketTop(b), jitterMax);
+      break;
+    }
+  }
+
+  out << std::setw(10) << name
+      << std::setw(10) << jobs << " jobs"
+      << std::setw(8) << misses << " misses ("
+      << (jobs ? 100.0*misses/jobs : 0) << "%)"
+      << "  jitter " << (samples ? 1e-3*jitterSum/samples : 0)
+      << "/" << 1e-3*p99 << "/" << 1e-3*jitterMax << " us mean/p99/max"
+      << "  worst overrun " << 1e-3*overrunMax << " us";
+  if (resyncs)
+    out << "  resyncs " << resyncs;
+  out << std::endl;
+}
+
+bool Pacer::PinThread(int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -1,6 +1,6 @@
 #include "include/plotter.h"
 
-Plotter::Plotter(const std::string& filePath, bool LOAD) : pi(3.1415926535897)
+Plotter::Plotter(const std::string& filePath, bool LOAD, double _overview, ValueAggregate aggregate) : pi(3.1415926535897)
 {
   // Load Simulation Data
   std::string picFolder(filePath + "pictures/");
@@ -11,10 +11,11 @@ Plotter::Plotter(const std::string& filePath, bool LOAD) : pi(3.1415926535897)
 
   folder = filePath;
   saveFolder = picFolder;
-  arma::mat simtime, loader;
+  overview = _overview;
 
   // Simulation Time
-  simtime.load(folder + "simtime.dat");
+  lengthSim = 0;
+  const arma::mat& simtime = Load("simtime", 1);
   lengthSim = simtime.size();
   maxTime = arma::max(simtime.col(0));
   freq = lengthSim/maxTime;
@@ -22,12 +23,12 @@ Plotter::Plotter(const std::string& filePath, bool LOAD) : pi(3.1415926535897)
   limTime[1] = maxTime;
 
   // Robot Motion View
-  loader.load(folder + "state.dat");
+  const arma::mat& state = Load("state", 12);
   pos.zeros(lengthSim, 3);
   rot.zeros(lengthSim, 3);
   for (int i = 0; i < 3; i++) {
-    pos.col(i) = loader.row(i+6).t();
-    rot.col(i) = loader.row(i).t();
+    pos.col(i) = state.col(i+6);
+    rot.col(i) = state.col(i);
   }
   limX[0] = arma::min(pos.col(0)) - arma::min(pos.col(0))*0.1;
   limX[1] = arma::max(pos.col(0)) + arma::max(pos.col(0))*0.1;
@@ -42,81 +43,148 @@ Plotter::Plotter(const std::string& filePath, bool LOAD) : pi(3.1415926535897)
   theta.col(0) = simtime;
   theta.col(1) = rot.col(0);
   omega.col(0) = simtime;
-  omega.col(1) = loader.row(3).t();
+  omega.col(1) = state.col(3);
   limTheta[0] = arma::min(theta.col(1)) - arma::min(theta.col(1))*0.1;
   limTheta[1] = arma::max(theta.col(1)) + arma::max(theta.col(1))*0.1;
   limOmega[0] = arma::min(omega.col(1)) - arma::min(omega.col(1))*0.1;
   limOmega[1] = arma::max(omega.col(1)) + arma::max(omega.col(1))*0.1;
-  loader.clear();
 
   // Classical Controller Forces
-  loader.load(folder + "control.dat");
+  const arma::mat& control = Load("control", 4);
   lift.zeros(lengthSim, 2);
   tau1.zeros(lengthSim, 2);
   tau2.zeros(lengthSim, 2);
   lift.col(0) = simtime;
-  lift.col(1) = loader.row(0).t();
+  lift.col(1) = control.col(0);
   tau1.col(0) = simtime;
-  tau1.col(1) = loader.row(1).t();
+  tau1.col(1) = control.col(1);
   tau2.col(0) = simtime;
-  tau2.col(1) = loader.row(2).t();
+  tau2.col(1) = control.col(2);
   limLift[0] = arma::min(lift.col(1)) - arma::min(lift.col(1))*0.1;
   limLift[1] = arma::max(lift.col(1)) + arma::max(lift.col(1))*0.1;
   limTau1[0] = arma::min(tau1.col(1)) - arma::min(tau1.col(1))*0.1;
   limTau1[1] = arma::max(tau1.col(1)) + arma::max(tau1.col(1))*0.1;
   limTau2[0] = arma::min(tau2.col(1)) - arma::min(tau2.col(1))*0.1;
   limTau2[1] = arma::max(tau2.col(1)) + arma::max(tau2.col(1))*0.1;
-  loader.clear();
 
   // Network Populations Activity
-  loader.load(folder + "network.dat");
+  const arma::mat& network = Load("network", 3);
   value.zeros(lengthSim, 2);
   value.col(0) = simtime;
-  value.col(1) = loader.row(0).t();
+  value.col(1) = network.col(0);
   policy.zeros(lengthSim, 2);
   policy.col(0) = simtime;
-  policy.col(1) = loader.row(1).t();
+  policy.col(1) = network.col(1);
   dopa.zeros(lengthSim, 2);
   dopa.col(0) = simtime;
-  dopa.col(1) = loader.row(2).t();
+  dopa.col(1) = network.col(2);
   limValue[0] = arma::min(value.col(1)) - arma::min(value.col(1))*0.1;
   limValue[1] = arma::max(value.col(1)) + arma::max(value.col(1))*0.1;
   limPolicy[0] = arma::min(policy.col(1));
   limPolicy[1] = arma::max(policy.col(1));
   limDopa[0] = arma::min(dopa.col(1)) - arma::min(dopa.col(1))*0.1;
   limDopa[1] = arma::max(dopa.col(1)) + arma::max(dopa.col(1))*0.1;
-  loader.clear();
 
   // Environment Reward and TD-error calculation
-  loader.load(folder + "environment.dat");
+  const arma::mat& environment = Load("environment", 2);
   reward.zeros(lengthSim, 2);
   reward.col(0) = simtime;
-  reward.col(1) = loader.row(0).t();
+  reward.col(1) = environment.col(0);
   tdError.zeros(lengthSim, 2);
   tdError.col(0) = simtime;
-  tdError.col(1) = loader.row(1).t();
+  tdError.col(1) = environment.col(1);
   limRew[0] = arma::min(reward.col(1)) - arma::min(reward.col(1))*0.1;
   limRew[1] = arma::max(reward.col(1)) + arma::max(reward.col(1))*0.1;
   limTDerr[0] = arma::min(tdError.col(1)) - arma::min(tdError.col(1))*0.1;
   limTDerr[1] = arma::max(tdError.col(1)) + arma::max(tdError.col(1))*0.1;
-  loader.clear();
 
   // Netowrk Weights
-  connToCritic.load(folder + "network/connToCritic.dat");
-  connToActor.load(folder + "network/connToActor.dat");
+  LoadConnections(connToCritic, folder + "network/connToCritic");
+  LoadConnections(connToActor, folder + "network/connToActor");
 
   // Value Function Surf
   if (LOAD)
-    valueMat.load(folder + "valueMatrix.dat");
+    LoadColumns(valueMat, folder + "valueMatrix");
 
-  BuilValueMat();
+  BuilValueMat(aggregate);
 }
 
 Plotter::Plotter(): pi(3.1415926535897) {}
 
-Plotter::~Plotter()
+const arma::mat& Plotter::Load(const std::string& name, int channels)
 {
+  std::string path(folder + name);
+  arma::mat *data = NULL;
+  double rate = 0;
+
+  if (overview > 0) {
+    // Decimated level: keep the mean of each column (min, max, mean). Only
+    // levels below the channel rate are recorded, the others come from the
+    // full resolution file
+    std::ostringstream level;
+    level << path << ".r" << overview;
+    ColumnReader reader(level.str() + ".bin");
+    arma::mat stats;
+    if (reader.IsOpen()) {
+      rate = reader.Rate();
+      reader.Load(stats);
+    }
+    else
+      LoadColumns(stats, level.str());
+
+    if (stats.n_rows > 0 && stats.n_cols >= 3) {
+      data = new arma::mat(stats.n_rows, stats.n_cols/3);
+      for (int i = 0; i < data->n_cols; ++i)
+        data->col(i) = stats.col(3*i + 2);
+    }
+    else
+      std::cout << level.str() << " not found, " << name << " at full resolution" << std::endl;
+  }
+
+  if (!data) {
+    ColumnReader *reader = new ColumnReader(path + ".bin");
+    rate = reader->IsOpen() ? reader->Rate() : 0;
+    if (reader->IsOpen() && reader->Data()) {
+      // Single block (compacted by the Recorder): read in place
+      data = new arma::mat(const_cast<double*>(reader->Data()), reader->Length(), reader->Columns(), false, true);
+      readers.push_back(reader);
+    }
+    else {
+      delete reader;
+      data = new arma::mat;
+      LoadColumns(*data, path, channels);
+    }
+  }
+
+  if (data->is_empty()) {
+    std::cerr << "No samples in " << path << ".bin or " << path << ".dat" << std::endl;
+    std::exit(1);
+  }
+
+  // Channels at another rate than simtime are held (or decimated) over its
+  // samples, by the rates in the headers when known
+  if (lengthSim == 0)
+    sampleRate = rate;
+  else if (data->n_rows != lengthSim) {
+    double step = rate > 0 && sampleRate > 0 ? rate/sampleRate : double(data->n_rows)/lengthSim;
+    arma::mat *held = new arma::mat(lengthSim, data->n_cols);
+    for (long k = 0; k < lengthSim; ++k)
+      held->row(k) = data->row(std::min<long>(k*step + 1e-6, data->n_rows - 1));
+    delete data;
+    data = held;
+  }
+
+  loaded.push_back(data);
+
+  return *data;
+}
 
+Plotter::~Plotter()
+{
+  for (int i = 0; i < loaded.size(); ++i)
+    delete loaded[i];
+  for (int i = 0; i < readers.size(); ++i)
+    delete readers[i];
 }
 
 void Plotter::InState()
@@ -418,7 +486,7 @@ void Plotter::ValueMat()
   gp << "splot " << gp.file1d(valueMat) << "matrix nonuniform with lines notitle\n";
 
   gp << "set terminal png\n"; // size 350,262 enhanced font 'Verdana,10'
-  dummy = asprintf(&cmd, "set output '%s/valueMatrix.png'\n", saveFolder.c_str());
+  dummy = asprintf(&cmd, "set output '%s/%s.png'\n", saveFolder.c_str(), valueName.c_str());
   gp << cmd;
   gp << "splot " << gp.file1d(valueMat) << "matrix nonuniform with lines notitle\n";
   gp.flush();
@@ -561,10 +629,57 @@ void Plotter::Simulation(double start, double end) {
   delete Robot;
 }
 
-void Plotter::BuilValueMat()
+// Bin index n of each label of valueMat (label == n*vRes, the comparison of
+// the former scan), so that a sample finds its cell directly
+static void BinTable(const arma::mat& labels, double vRes, long& binMin, std::vector<int>& table)
+{
+  long binMax = 0;
+  bool any = false;
+
+  for (int i = 0; i < labels.n_elem; ++i) {
+    long n = round(labels(i)/vRes);
+    if (labels(i) != n*vRes)
+      continue;
+    binMin = any ? std::min(binMin, n) : n;
+    binMax = any ? std::max(binMax, n) : n;
+    any = true;
+  }
+
+  table.clear();
+  if (!any)
+    return;
+
+  table.assign(binMax - binMin + 1, -1);
+  for (int i = 0; i < labels.n_elem; ++i) {
+    long n = round(labels(i)/vRes);
+    if (labels(i) == n*vRes)
+      table[n - binMin] = i;
+  }
+}
+
+void Plotter::BinValues(int first, int last, double vRes, std::vector<double>& sum, std::vector<long>& count)
+{
+  for (int k = first; k < last; k++) {
+    long nTheta = round(WrapTo2Pi(theta(k,1))/vRes) - rowMin,
+         nOmega = round(omega(k,1)/vRes) - colMin;
+    if (nTheta < 0 || nTheta >= rowOf.size() || nOmega < 0 || nOmega >= colOf.size() ||
+        rowOf[nTheta] < 0 || colOf[nOmega] < 0)
+      continue;
+
+    // Without sums (VALUE_LAST) count keeps the last sample + 1
+    long cell = (long)colOf[nOmega]*valueMat.n_rows + rowOf[nTheta];
+    if (sum.empty())
+      count[cell] = k + 1;
+    else {
+      sum[cell] += value(k,1);
+      count[cell]++;
+    }
+  }
+}
+
+void Plotter::BuilValueMat(ValueAggregate aggregate)
 {
-  double vRes = 0.1,
-         wrappedAngle = 0;
+  double vRes = 0.1;
 
   if (valueMat.is_empty()) {
     const double pi = 3.1415926535897;
@@ -584,16 +699,50 @@ void Plotter::BuilValueMat()
         valueMat.row(0).col(i) = round(valueMat.row(0).col(i)/vRes)*vRes;
   }
 
-  for (int k = 0; k < lengthSim; k++) {
-    wrappedAngle = WrapTo2Pi(theta(k,1));
-    for (int i = 0; i < valueMat.n_rows; ++i) {
-      if (valueMat(i,0) == round(wrappedAngle/vRes)*vRes) {
-        for (int j = 0; j < valueMat.n_cols; ++j) {
-          if (valueMat(0,j) == round(omega(k,1)/vRes)*vRes)
-                    valueMat(i, j) = value(k,1);
-        }
+  // Samples binned straight into their cell (row label theta, column label
+  // omega) by slices in parallel, partial grids merged in slice order
+  BinTable(valueMat.col(0), vRes, rowMin, rowOf);
+  BinTable(valueMat.row(0), vRes, colMin, colOf);
+
+  int nThreads = std::max(1u, std::min(std::thread::hardware_concurrency(), 16u));
+  if (lengthSim < 100000)
+    nThreads = 1;
+
+  // Mean and count maps are results of this run alone, under their own
+  // names: valueMatrix.bin (read back by LOAD) holds the value map only
+  bool last = aggregate == VALUE_LAST;
+  valueName = last ? "valueMatrix" : aggregate == VALUE_MEAN ? "valueMatrix.mean" : "valueMatrix.count";
+  if (!last)
+    valueMat.submat(1, 1, valueMat.n_rows - 1, valueMat.n_cols - 1).zeros();
+
+  std::vector < std::vector<double> > sums(nThreads, std::vector<double>(last ? 0 : valueMat.n_elem, 0));
+  std::vector < std::vector<long> > counts(nThreads, std::vector<long>(valueMat.n_elem, 0));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nThreads; ++t) {
+    int first = (long)lengthSim*t/nThreads, end = (long)lengthSim*(t + 1)/nThreads;
+    workers.push_back(std::thread(&Plotter::BinValues, this, first, end, vRes, std::ref(sums[t]), std::ref(counts[t])));
+  }
+  for (int t = 0; t < nThreads; ++t)
+    workers[t].join();
+
+  for (long cell = 0; cell < valueMat.n_elem; ++cell) {
+    double sum = 0;
+    long count = 0;
+    for (int t = 0; t < nThreads; ++t) {
+      if (last)
+        count = std::max(count, counts[t][cell]);
+      else {
+        sum += sums[t][cell];
+        count += counts[t][cell];
       }
     }
+
+    if (count == 0)
+      continue;
+    if (last)
+      valueMat(cell) = value(count - 1,1);
+    else
+      valueMat(cell) = aggregate == VALUE_MEAN ? sum/count : count;
   }
 
   explorePath.zeros(lengthSim,3);
@@ -604,10 +753,11 @@ void Plotter::BuilValueMat()
   for (int i = 0; i < lengthSim; i++)
     explorePath(i,0) = WrapTo2Pi(explorePath(i,0));
 
-  explorePath.save(folder + "explorePath.dat", arma::raw_ascii);
-  valueMat.save(folder + "valueMatrix.dat",arma::raw_ascii);
+  ColumnWriter::Save(explorePath, folder + "explorePath.bin", freq, "theta omega value");
+  ColumnWriter::Save(valueMat, folder + valueName + ".bin");
   XYZSurfReshape(valueMat);
-  valueReshaped.save(folder + "valueReshaped.dat",arma::raw_ascii);
+  std::string reshaped(folder + "valueReshaped" + valueName.substr(11) + ".bin");
+  ColumnWriter::Save(valueReshaped, reshaped, 0, "theta omega value");
 }
 
 void Plotter::XYZSurfReshape(arma::mat& A)
@@ -0,0 +1,234 @@
+/*
+ *  profiler.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include "include/profiler.h"
+
+Profiler::Histogram Profiler::phases[Profiler::MaxPhases];
+std::atomic<int> Profiler::numPhases(0);
+
+std::atomic<bool> Profiler::tracing(false);
+int Profiler::tracePid = 0, Profiler::traceCapacity = 0;
+Profiler::Clock::time_point Profiler::traceStart;
+std::vector<Profiler::TraceBuffer*> Profiler::buffers;
+
+static std::mutex traceLock;
+
+int Profiler::Phase(const char *name)
+{
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+
+  int n = numPhases.load();
+  for (int i = 0; i < n; ++i)
+    if (phases[i].name == name)
+      return i;
+
+  // Too many phases: the last one collects the rest
+  if (n == MaxPhases)
+    return MaxPhases - 1;
+
+  phases[n].name = name;
+  numPhases.store(n + 1);
+
+  return n;
+}
+
+int Profiler::Bucket(uint64_t ns)
+{
+  if (ns < (1u << SubBits))
+    return ns;
+
+  int e = 63 - __builtin_clzll(ns);
+  return (e - SubBits + 1)*(1 << SubBits) + ((ns >> (e - SubBits)) & ((1 << SubBits) - 1));
+}
+
+uint64_t Profiler::BucketTop(int bucket)
+{
+  if (bucket < (1 << SubBits))
+    return bucket;
+
+  int e = bucket/(1 << SubBits) + SubBits - 1,
+      sub = bucket % (1 << SubBits);
+  return ((uint64_t)((1 << SubBits) + sub + 1) << (e - SubBits)) - 1;
+}
+
+void Profiler::Add(int phase, Clock::time_point start, Clock::time_point end)
+{
+  Histogram& h = phases[phase];
+  int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  uint64_t v = ns < 0 ? 0 : ns,
+           prev = h.max.load(std::memory_order_relaxed);
+
+  if (tracing.load(std::memory_order_relaxed)) {
+    TraceBuffer *buf = ThreadBuffer();
+    Span& span = buf->spans[buf->written++ % buf->spans.size()];
+    span.phase = phase;
+    span.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceStart).count();
+    span.duration = v;
+  }
+
+  h.bins[Bucket(v)].fetch_add(1, std::memory_order_relaxed);
+  h.sum.fetch_add(v, std::memory_order_relaxed);
+  h.count.fetch_add(1, std::memory_order_relaxed);
+  while (v > prev && !h.max.compare_exchange_weak(prev, v, std::memory_order_relaxed));
+}
+
+uint64_t Profiler::Percentile(Histogram& h, uint64_t count, double p)
+{
+  uint64_t rank = (uint64_t)(p*count + 0.5), seen = 0;
+  if (rank < 1)
+    rank = 1;
+
+  for (int b = 0; b < NumBuckets; ++b) {
+    seen += h.bins[b].load(std::memory_order_relaxed);
+    if (seen >= rank)
+      return BucketTop(b);
+  }
+
+  return h.max.load(std::memory_order_relaxed);
+}
+
+void Profiler::Report(std::ostream& out)
+{
+  out << std::setw(20) << "Phase"
+      << std::setw(12) << "Count"
+      << std::setw(12) << "Mean[us]"
+      << std::setw(12) << "p50[us]"
+      << std::setw(12) << "p99[us]"
+      << std::setw(12) << "Max[us]" << std::endl;
+
+  int n = numPhases.load();
+  for (int i = 0; i < n; ++i) {
+    Histogram& h = phases[i];
+    uint64_t count = h.count.load(std::memory_order_relaxed),
+             maxNs = h.max.load(std::memory_order_relaxed);
+    if (count == 0)
+      continue;
+
+    out << std::setw(20) << h.name
+        << std::setw(12) << count
+        << std::setw(12) << 1e-3*h.sum.load(std::memory_order_relaxed)/count
+        << std::setw(12) << 1e-3*std::min(Percentile(h, count, 0.50), maxNs)
+        << std::setw(12) << 1e-3*std::min(Percentile(h, count, 0.99), maxNs)
+        << std::setw(12) << 1e-3*maxNs << std::endl;
+  }
+}
+
+bool Profiler::Save(const std::string& fname)
+{
+  std::ofstream out(fname.c_str());
+  Report(out);
+
+  return (bool)out;
+}
+
+void Profiler::Reset()
+{
+  int n = numPhases.load();
+  for (int i = 0; i < n; ++i) {
+    phases[i].count = 0;
+    phases[i].sum = 0;
+    phases[i].max = 0;
+    for (int b = 0; b < NumBuckets; ++b)
+      phases[i].bins[b] = 0;
+  }
+}
+
+void Profiler::StartTrace(int pid, int capacity)
+{
+  {
+    std::lock_guard<std::mutex> guard(traceLock);
+    tracePid = pid;
+    traceCapacity = capacity;
+    traceStart = Clock::now();
+    tracing.store(true);
+  }
+
+  // The calling thread is the first track
+  ThreadBuffer()->name = "main";
+}
+
+Profiler::TraceBuffer* Profiler::ThreadBuffer()
+{
+  static thread_local TraceBuffer *buf = NULL;
+
+  // First span of this thread: the only allocation
+  if (!buf) {
+    std::lock_guard<std::mutex> guard(traceLock);
+    buf = new TraceBuffer;
+    buf->tid = buffers.size();
+    buf->name = "thread " + std::to_string(buf->tid);
+    buf->spans.resize(traceCapacity);
+    buf->written = 0;
+    buffers.push_back(buf);
+  }
+
+  return buf;
+}
+
+void Profiler::NameThread(const std::string& name)
+{
+  if (tracing.load())
+    ThreadBuffer()->name = name;
+}
+
+void Profiler::WriteTrace(std::ostream& out)
+{
+  std::lock_guard<std::mutex> guard(traceLock);
+
+  out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << tracePid
+      << ", \"args\": {\"name\": \"rank " << tracePid << "\"}}";
+
+  for (int i = 0; i < buffers.size(); ++i) {
+    TraceBuffer *buf = buffers[i];
+    uint64_t size = buf->spans.size(),
+             first = buf->written > size ? buf->written - size : 0;
+
+    out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << tracePid
+        << ", \"tid\": " << buf->tid << ", \"args\": {\"name\": \"" << buf->name << "\"}}";
+
+    out << std::fixed << std::setprecision(3);
+    for (uint64_t n = first; n < buf->written; ++n) {
+      Span& span = buf->spans[n % size];
+      out << ",\n{\"name\": \"" << phases[span.phase].name
+          << "\", \"ph\": \"X\", \"pid\": " << tracePid
+          << ", \"tid\": " << buf->tid
+          << ", \"ts\": " << 1e-3*span.start
+          << ", \"dur\": " << 1e-3*span.duration << "}";
+    }
+    out.unsetf(std::ios::floatfield);
+  }
+}
+
+bool Profiler::SaveTrace(const std::string& fname)
+{
+  std::ofstream out(fname.c_str());
+
+  out << "{\"traceEvents\": [\n";
+  WriteTrace(out);
+  out << "\n]}" << std::endl;
+
+  return (bool)out;
+}
@@ -34,6 +34,13 @@ Receiver::Receiver (int *neurons, int num_pops)
 	}
 
 	spikeFilter = new Decoder(1.0);
+
+	idCritic = idActor = idDopa = -1;
+	ownFirst = 0;
+	ownEnd = bound.back();
+	reducer = NULL;
+	traffic = NULL;
+	decoded = false;
 }
 
 Receiver::Receiver () {}
@@ -44,7 +51,7 @@ Receiver::~Receiver ()
 	delete value;
 }
 
-void Receiver::operator () (double t, MUSIC::GlobalIndex id)
+void Receiver::HandleEvent(double t, int id)
 {
 	for (int i = 0; i < storage.size(); ++i)
 	{
@@ -56,6 +63,30 @@ void Receiver::operator () (double t, MUSIC::GlobalIndex id)
 	}
 
 	storage[pop][new_id].push_back(t);
+	decoded = false;
+
+	if (traffic)
+		traffic->Receive(groups[pop], t);
+}
+
+void Receiver::SetTraffic(Traffic *_traffic)
+{
+	traffic = _traffic;
+	groups.clear();
+	if (!traffic)
+		return;
+
+	for (int i = 0; i < storage.size(); ++i)
+	{
+		if (i == idCritic)
+			groups.push_back(traffic->AddGroup("critic", false));
+		else if (i == idActor)
+			groups.push_back(traffic->AddGroup("actor", false));
+		else if (i == idDopa)
+			groups.push_back(traffic->AddGroup("dopa", false));
+		else
+			groups.push_back(traffic->AddGroup("pop" + std::to_string(i), false));
+	}
 }
 
 std::vector <std::vector <double> >* Receiver::GetSpikes(int pop)
@@ -93,46 +124,91 @@ void Receiver::SetDopa(int idPop, double *param)
 	b_dopa = param[1];
 }
 
-double* Receiver::GetValue(double tickt, double reward)
+void Receiver::SetPartial(int first, int count, PartialSum *_reducer)
 {
-	value[0] = 0;
-	value[1] = 0;
-	for (int i = 0; i < storage[idCritic].size(); ++i){
-			value[0] = value[0] + spikeFilter->NLKernel(tickt, &storage[idCritic][i]);
-			value[1] = value[1] + spikeFilter->NLKernelDev(tickt, &storage[idCritic][i])
-								 - spikeFilter->NLKernel(tickt, &storage[idCritic][i])/tau_r;
+	ownFirst = first;
+	ownEnd = first + count;
+	reducer = _reducer;
+	decoded = false;
+}
+
+void Receiver::Owned(int pop, int& lo, int& hi)
+{
+	int start = bound[pop] - storage[pop].size();
+
+	lo = std::max(0, ownFirst - start);
+	hi = std::min((int)storage[pop].size(), ownEnd - start);
+}
+
+void Receiver::Decode(double tickt)
+{
+	if (decoded && decodedAt == tickt)
+		return;
+
+	int lo, hi;
+	for (int k = 0; k < 5; ++k)
+		sums[k] = 0;
+
+	if (idCritic >= 0) {
+		Owned(idCritic, lo, hi);
+		for (int i = lo; i < hi; ++i){
+				double k = spikeFilter->NLKernel(tickt, &storage[idCritic][i]);
+				sums[0] = sums[0] + k;
+				sums[1] = sums[1] + spikeFilter->NLKernelDev(tickt, &storage[idCritic][i]) - k/tau_r;
+		}
 	}
 
-	value[0] = (A_critic/sizeCritic)*value[0] + b_critic;
-	value[1] = (A_critic/sizeCritic)*value[1] - b_critic/tau_r + reward;
+	if (idActor >= 0) {
+		Owned(idActor, lo, hi);
+		for (int i = lo; i < hi; ++i){
+				double k = spikeFilter->NLKernel(tickt, &storage[idActor][i]);
+				sums[2] = sums[2] + k*GetForce(i);
+				sums[3] = sums[3] + k;
+		}
+	}
+
+	if (idDopa >= 0) {
+		Owned(idDopa, lo, hi);
+		for (int i = lo; i < hi; ++i)
+				sums[4] = sums[4] + spikeFilter->ExpKernel(tickt, &storage[idDopa][i]);
+	}
+
+	// One collective per tick whichever readout is asked first
+	if (reducer)
+		reducer->Reduce(sums, 5);
+
+	decodedAt = tickt;
+	decoded = true;
+}
+
+double* Receiver::GetValue(double tickt, double reward)
+{
+	Decode(tickt);
+
+	value[0] = (A_critic/sizeCritic)*sums[0] + b_critic;
+	value[1] = (A_critic/sizeCritic)*sums[1] - b_critic/tau_r + reward;
 
 	return value;
 }
 
 double Receiver::GetAction(double tickt)
 {
-	policy = 0;
-	sumActor = 0;
-	for (int i = 0; i < storage[idActor].size(); ++i){
-			sumActor = sumActor + spikeFilter->NLKernel(tickt, &storage[idActor][i]);
-			policy = policy + spikeFilter->NLKernel(tickt, &storage[idActor][i])*GetForce(i);
-	}
+	Decode(tickt);
 
+	sumActor = sums[3];
 	if (sumActor == 0)
 			policy = 0;
 	else
-			policy = policy/sumActor;
+			policy = sums[2]/sumActor;
 
 	return policy;
 }
 
 double Receiver::GetDopa(double tickt)
 {
-	dopaActivity = 0;
-	for (int i = 0; i < storage[idDopa].size(); ++i)
-			dopaActivity = dopaActivity + spikeFilter->ExpKernel(tickt, &storage[idDopa][i]);
+	Decode(tickt);
 
-	dopaActivity = (A_dopa/sizeDopa)*dopaActivity + b_dopa;
+	dopaActivity = (A_dopa/sizeDopa)*sums[4] + b_dopa;
 
 	return dopaActivity;
 }
@@ -141,3 +217,39 @@ double Receiver::GetForce(int k)
 {
   return std::abs(double(k)-minID)/Q + F_min;
 }
+
+void Receiver::Save(std::ostream& out, double tickt)
+{
+	std::vector <double> recent;
+
+	Put(out, (uint64_t)storage.size());
+	for (int i = 0; i < storage.size(); ++i) {
+		Put(out, (uint64_t)storage[i].size());
+		for (int j = 0; j < storage[i].size(); ++j) {
+			recent.clear();
+			for (int k = 0; k < storage[i][j].size(); ++k)
+				if (storage[i][j][k] >= tickt - spikeFilter->Window())
+					recent.push_back(storage[i][j][k]);
+			Put(out, recent);
+		}
+	}
+}
+
+void Receiver::Load(std::istream& in, double shift)
+{
+	uint64_t pops = 0, neurons = 0;
+
+	Get(in, pops);
+	for (int i = 0; i < pops; ++i) {
+		Get(in, neurons);
+		for (int j = 0; j < neurons; ++j) {
+			std::vector <double> spikes;
+			Get(in, spikes);
+			for (int k = 0; k < spikes.size(); ++k)
+				spikes[k] += shift;
+			if (i < storage.size() && j < storage[i].size())
+				storage[i][j] = spikes;
+		}
+	}
+	decoded = false;
+}
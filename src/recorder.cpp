@@ -0,0 +1,259 @@
+/*
+ *  recorder.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "include/recorder.h"
+
+Recorder::Recorder(const std::string& _folder, RecordFormat _format, int _chunkSize, int _maxChunks)
+{
+  folder = _folder;
+  format = _format;
+  chunkSize = _chunkSize;
+  maxChunks = _maxChunks;
+  allocated = 0;
+  done = false;
+
+  writer = std::thread(&Recorder::Write, this);
+}
+
+Recorder::~Recorder()
+{
+  Close();
+
+  for (int i = 0; i < files.size(); ++i)
+    delete files[i];
+  for (int i = 0; i < columnFiles.size(); ++i)
+    delete columnFiles[i];
+  for (int i = 0; i < pool.size(); ++i)
+    delete pool[i];
+}
+
+void Recorder::SetLevels(double *rates, int numLevels)
+{
+  levelRates.assign(rates, rates + numLevels);
+}
+
+int Recorder::AddChannel(const std::string& name, int size, double rate, const std::string& columns, int _decimate)
+{
+  std::vector<Level> channelLevels;
+  std::vector<std::string> names;
+  std::istringstream split(columns);
+  std::string label;
+
+  rate /= _decimate;
+
+  while (split >> label)
+    names.push_back(label);
+  for (int i = names.size(); i < size; ++i) {
+    std::ostringstream def;
+    def << "col" << i;
+    names.push_back(def.str());
+  }
+
+  for (int l = 0; l < levelRates.size(); ++l) {
+    Level level;
+    level.factor = round(rate/levelRates[l]);
+    if (rate <= 0 || level.factor < 2)
+      continue;
+
+    std::ostringstream levelName;
+    std::string levelColumns;
+    levelName << name << ".r" << levelRates[l];
+    for (int i = 0; i < size; ++i)
+      levelColumns += names[i] + ".min " + names[i] + ".max " + names[i] + ".mean ";
+
+    level.channel = Open(levelName.str(), 3*size, rate/level.factor, levelColumns);
+    level.count = 0;
+    level.acc.resize(3*size);
+    channelLevels.push_back(level);
+  }
+
+  int channel = Open(name, size, rate, columns);
+  decimate[channel] = _decimate;
+  levels[channel] = channelLevels;
+
+  return channel;
+}
+
+int Recorder::Open(const std::string& name, int size, double rate, const std::string& columns)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  sizes.push_back(size);
+  paths.push_back(folder + name + (format == BINARY ? ".bin" : ".dat"));
+  decimate.push_back(1);
+  counts.push_back(0);
+  levels.push_back(std::vector<Level>());
+  if (format == BINARY) {
+    files.push_back(NULL);
+    columnFiles.push_back(new ColumnWriter(paths.back(), size, chunkSize, rate, columns));
+  }
+  else {
+    files.push_back(new std::ofstream(paths.back().c_str()));
+    *files.back() << std::scientific << std::setprecision(10);
+    columnFiles.push_back(NULL);
+  }
+  current.push_back(NULL);
+
+  return sizes.size() - 1;
+}
+
+void Recorder::Record(int channel, const double *data)
+{
+  if (counts[channel]++ % decimate[channel] != 0)
+    return;
+
+  Append(channel, data);
+
+  for (int l = 0; l < levels[channel].size(); ++l) {
+    Level& level = levels[channel][l];
+    double *acc = level.acc.data();
+
+    for (int i = 0; i < sizes[channel]; ++i, acc += 3) {
+      if (level.count == 0) {
+        acc[0] = acc[1] = acc[2] = data[i];
+        continue;
+      }
+      acc[0] = std::min(acc[0], data[i]);
+      acc[1] = std::max(acc[1], data[i]);
+      acc[2] += data[i];
+    }
+
+    // Incomplete windows at the end of the run are dropped
+    if (++level.count == level.factor) {
+      for (int i = 0; i < sizes[channel]; ++i)
+        level.acc[3*i + 2] /= level.factor;
+      Append(level.channel, level.acc.data());
+      level.count = 0;
+    }
+  }
+}
+
+void Recorder::Append(int channel, const double *data)
+{
+  Chunk *chunk = current[channel];
+
+  if (!chunk)
+    chunk = current[channel] = NewChunk(channel);
+
+  chunk->data.insert(chunk->data.end(), data, data + sizes[channel]);
+
+  if (++chunk->samples == chunkSize) {
+    Push(chunk);
+    current[channel] = NULL;
+  }
+}
+
+void Recorder::Flush()
+{
+  for (int i = 0; i < current.size(); ++i) {
+    if (current[i]) {
+      Push(current[i]);
+      current[i] = NULL;
+    }
+  }
+}
+
+void Recorder::Close()
+{
+  if (!writer.joinable())
+    return;
+
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    done = true;
+  }
+  ready.notify_one();
+  writer.join();
+
+  for (int i = 0; i < columnFiles.size(); ++i)
+    if (columnFiles[i]) {
+      columnFiles[i]->Close();
+      ColumnWriter::Compact(paths[i]);
+    }
+}
+
+Recorder::Chunk* Recorder::NewChunk(int channel)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  Chunk *chunk;
+
+  // Reuse a written chunk, allocate only up to the queue bound
+  freed.wait(lock, [this]{ return !pool.empty() || allocated < maxChunks + (int)current.size(); });
+  if (pool.empty()) {
+    chunk = new Chunk;
+    allocated++;
+  }
+  else {
+    chunk = pool.front();
+    pool.pop_front();
+  }
+  lock.unlock();
+
+  chunk->channel = channel;
+  chunk->samples = 0;
+  chunk->data.clear();
+  chunk->data.reserve(chunkSize*sizes[channel]);
+
+  return chunk;
+}
+
+void Recorder::Push(Chunk *chunk)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    queue.push_back(chunk);
+  }
+  ready.notify_one();
+}
+
+void Recorder::Write()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (true) {
+    ready.wait(lock, [this]{ return !queue.empty() || done; });
+    if (queue.empty())
+      break;
+
+    Chunk *chunk = queue.front();
+    queue.pop_front();
+    std::ofstream *file = files[chunk->channel];
+    ColumnWriter *columnFile = columnFiles[chunk->channel];
+    int size = sizes[chunk->channel];
+    lock.unlock();
+
+    if (columnFile)
+      columnFile->WriteBlock(chunk->data.data(), chunk->samples);
+    else {
+      for (int s = 0; s < chunk->samples; ++s) {
+        for (int i = 0; i < size; ++i)
+          *file << ' ' << chunk->data[s*size + i];
+        *file << '\n';
+      }
+      file->flush();
+    }
+
+    lock.lock();
+    pool.push_back(chunk);
+    freed.notify_one();
+  }
+}
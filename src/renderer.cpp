@@ -0,0 +1,182 @@
+/*
+ *  renderer.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdlib>
+#include <GL/gl.h>
+#include "include/renderer.h"
+
+Renderer::Renderer(const std::string& _title, int _length, int _height, double _fps, const std::string& _graphicFolder)
+{
+  title = _title;
+  length = _length;
+  height = _height;
+  fps = _fps;
+  graphicFolder = _graphicFolder;
+  running = false;
+  rendered = 0;
+  published = 0;
+  capture = NULL;
+  headless = false;
+  frameStart = -1;
+  frameCount = 0;
+  late = 0;
+}
+
+Renderer::~Renderer()
+{
+  Stop();
+}
+
+void Renderer::SetCapture(FrameCapture *_capture)
+{
+  capture = _capture;
+}
+
+void Renderer::SetHeadless(bool _headless)
+{
+  headless = _headless;
+}
+
+void Renderer::Publish(const arma::vec& q, double t)
+{
+  Pose pose = {{q(7), q(8), q(6)}, {q(1), q(2), q(0)}, t};
+  poses.Write(pose);
+  published++;
+
+  if (!capture)
+    return;
+
+  // One video frame per 1/fps of simulation time (repeated over long steps)
+  if (frameStart < 0)
+    frameStart = t;
+  std::lock_guard<std::mutex> lock(frameLock);
+  for (; t >= frameStart + frameCount/fps; ++frameCount) {
+    if (frames.size() < capture->Buffers())
+      frames.push_back(pose);
+    else
+      late++;
+  }
+}
+
+void Renderer::Start()
+{
+  if (running)
+    return;
+
+  running = true;
+  thread = std::thread(&Renderer::Loop, this);
+}
+
+void Renderer::Stop()
+{
+  running = false;
+  if (thread.joinable())
+    thread.join();
+}
+
+void Renderer::Loop()
+{
+  Profiler::NameThread("render");
+
+  if (headless) {
+    setenv("SDL_VIDEODRIVER", "offscreen", 0);
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+  }
+
+  // The OpenGL context belongs to this thread
+  Display* Frame = new Display(title.c_str(), length, height);
+  Camera *Cam = new Camera(glm::vec3(-0.3,0.2,0.2), glm::vec3(0,0,0), glm::vec3(0,1,0));
+  Light *Lamp = new Light(glm::vec3(2,1,5));
+  Shader *myShader = new Shader(graphicFolder + "vertex.glsl", graphicFolder + "fragment.glsl");
+  Model *Base = new Model(graphicFolder, "base");
+  Model *Robot = new Model(graphicFolder, "robobee");
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+  std::chrono::steady_clock::duration period =
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1/fps));
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+  Pose pose;
+
+  auto draw = [&](const Pose& pose) {
+    Frame->Clear(0.0f, 0.1f, 0.15f, 1.0f);
+    myShader->Bind();
+    Robot->SetPos( glm::vec3( pose.pos[0], pose.pos[1], pose.pos[2] ) );
+    Robot->SetRot( glm::vec3( pose.rot[0], pose.rot[1], pose.rot[2] ) );
+    myShader->Update(*Robot, *Cam, *Lamp);
+    Robot->Draw();
+    myShader->Update(*Base, *Cam, *Lamp);
+    Base->Draw();
+  };
+
+  // Video frames queued by Publish, read back from the back buffer (never
+  // shown); dropped when the encoder lags behind
+  auto record = [&]() {
+    Pose frame;
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(frameLock);
+        if (frames.empty())
+          return;
+        frame = frames.front();
+        frames.pop_front();
+      }
+      PROFILE_SCOPE("render capture");
+      unsigned char *pixels = capture->Acquire();
+      if (!pixels)
+        continue;
+      draw(frame);
+      glReadPixels(0, 0, capture->Width(), capture->Height(), GL_RGB, GL_UNSIGNED_BYTE, pixels);
+      capture->Submit(pixels);
+    }
+  };
+
+  while (running) {
+    next += period;
+
+    if (capture)
+      record();
+
+    // Live window, paced by the wall clock
+    if (poses.Read(pose)) {
+      PROFILE_SCOPE("render frame");
+      draw(pose);
+      Frame->Update();
+      rendered++;
+    }
+
+    // A late frame is not made up for
+    if (next < std::chrono::steady_clock::now())
+      next = std::chrono::steady_clock::now();
+    std::this_thread::sleep_until(next);
+  }
+
+  // Frames published after the last pass
+  if (capture)
+    record();
+
+  delete Robot;
+  delete Base;
+  delete myShader;
+  delete Lamp;
+  delete Cam;
+  delete Frame;
+}
@@ -88,6 +88,23 @@ void Robobee::InitRobot(arma::vec& q0)
             c(0)*c(1)*s(2)-s(0)*s(1)*c(2)};
 }
 
+void Robobee::Save(std::ostream& out)
+{
+	PutMat(out, q);
+	PutMat(out, quat);
+}
+
+void Robobee::Load(std::istream& in)
+{
+	// The quaternion is not renormalized while integrating: keep it as it is
+	GetMat(in, q);
+	GetMat(in, quat);
+	theta = q.rows(0,2);
+	omega = q.rows(3,5);
+	pos = q.rows(6,8);
+	vel = q.rows(9,11);
+}
+
 arma::vec& Robobee::BeeDynamics(arma::vec& u)
 {
 	f.zeros();
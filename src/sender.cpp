@@ -21,9 +21,13 @@
 
 #include "include/sender.h"
 
-Sender::Sender(MUSIC::EventOutputPort *outport, double TICK)
+Sender::Sender(EventOutput *outport, double TICK)
 {
     outputPort = outport;
+    stateRates = NULL;
+    rewardRates = NULL;
+    traffic = NULL;
+    counter = NULL;
     psgRate = 0;
     dist = 0;
     pi = 3.1415926535897;
@@ -41,6 +45,7 @@ Sender::~Sender ()
   delete rangeState;
   delete arrs;
   delete spikeGen;
+  delete counter;
 }
 
 void Sender::CreatePlaceCells (int numState, int *stateId, int *stateRes, bool *stateType, double *stateRange, double maxRate)
@@ -94,6 +99,27 @@ void Sender::CreatePlaceCells (int numState, int *stateId, int *stateRes, bool *
       exit_cond = exit_cond + (pCells[i].size()-1);
 }
 
+void Sender::SetRateOutput(RateOutput *rateport, bool state, bool reward)
+{
+  stateRates = state ? rateport : NULL;
+  rewardRates = reward ? rateport : NULL;
+}
+
+void Sender::SetTraffic(Traffic *_traffic)
+{
+  traffic = _traffic;
+  if (traffic && !counter) {
+    counter = new EventCounter(outputPort);
+    outputPort = counter;
+  }
+
+  if (traffic) {
+    placeGroup = traffic->AddGroup("place", true);
+    rewExGroup = traffic->AddGroup("reward+", true);
+    rewInGroup = traffic->AddGroup("reward-", true);
+  }
+}
+
 void Sender::SendState (arma::vec& q, double tickt)
 {
   while (!status) {
@@ -139,7 +165,10 @@ void Sender::SendState (arma::vec& q, double tickt)
                 psgRate = psgRate/std::exp(std::pow(dist, 2) / std::pow(std::abs(rangeState[r])/resState[r], 2));
               }
 
-              spikeGen->PoissonSpikeGenerator(outputPort, psgRate, tickt, cellsCounter);
+              if (stateRates)
+                stateRates->SetRate(cellsCounter, psgRate);
+              else
+                spikeGen->PoissonSpikeGenerator(outputPort, psgRate, tickt, cellsCounter);
               cellsCounter++;
           }
 
@@ -152,18 +181,44 @@ void Sender::SendState (arma::vec& q, double tickt)
 
   status = false;
   cellsCounter = 0;
+
+  if (traffic)
+    traffic->Count(placeGroup, counter->Take());
 }
 
 void Sender::SendReward(double reward, double tickt)
 {
   if (reward >= 0){
     inputRew = InputRate(std::abs(reward), 0, 2000, 0, 1000);
-    spikeGen->PoissonSpikeGenerator(outputPort, inputRew, tickt, numPlaceCells);
+    if (rewardRates) {
+      rewardRates->SetRate(numPlaceCells, inputRew);
+      rewardRates->SetRate(numPlaceCells+1, 0);
+    }
+    else
+      spikeGen->PoissonSpikeGenerator(outputPort, inputRew, tickt, numPlaceCells);
   }
   else if (reward < 0){
     inputRew = InputRate(std::abs(reward), 0, 500, 0, 1000);
-    spikeGen->PoissonSpikeGenerator(outputPort, inputRew, tickt, numPlaceCells+1);
+    if (rewardRates) {
+      rewardRates->SetRate(numPlaceCells, 0);
+      rewardRates->SetRate(numPlaceCells+1, inputRew);
+    }
+    else
+      spikeGen->PoissonSpikeGenerator(outputPort, inputRew, tickt, numPlaceCells+1);
   }
+
+  if (traffic)
+    traffic->Count(reward >= 0 ? rewExGroup : rewInGroup, counter->Take());
+}
+
+void Sender::Save(std::ostream& out)
+{
+  spikeGen->Save(out);
+}
+
+void Sender::Load(std::istream& in)
+{
+  spikeGen->Load(in);
 }
 
 double Sender::InputRate(
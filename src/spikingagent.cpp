@@ -0,0 +1,471 @@
+/*
+ *  spikingagent.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "include/spikingagent.h"
+
+SpikingAgent::SpikingAgent(int cells, int *pops, double TICK, Receiver *_inhandler, unsigned int seed)
+{
+  inhandler = _inhandler;
+  outhandler = NULL;
+
+  distribution = new distType(0,1);
+  generator = new genType(seed);
+  numberGenerator = new numGen(*generator, *distribution);
+
+  // Populations
+  nCells = cells;
+  nCritic = pops[0];
+  nActor = pops[1];
+  nDopa = pops[2];
+  nReadout = nCritic + nActor;
+
+  // Time
+  h = 0.1;
+  step = 0;
+  stepsPerTick = round(TICK*1000/h);
+  plasticPeriod = 10;   // 1 ms
+  lateralDelay = 10;    // 1 ms (NEST default delay)
+  ringSize = stepsPerTick + lateralDelay + 2;
+  inRing.resize(ringSize);
+  readoutRing.assign(ringSize, std::vector<double>(nReadout, 0));
+
+  // Critic and Actor: iaf_chs_2007
+  tau_epsp = 8.5;
+  tau_reset = 15.4;
+  U_th = 1.0;
+  U_epsp = 0.77;
+  U_reset = 2.31;
+  P11 = std::exp(-h/tau_epsp);
+  P21 = U_epsp*std::exp(1.0)/tau_epsp*h*P11;
+  P30 = std::exp(-h/tau_reset);
+  iSyn.assign(nReadout, 0);
+  vSyn.assign(nReadout, 0);
+  vSpike.assign(nReadout, 0);
+
+  // Dopaminergic neurons: iaf_cond_alpha with C_m, V_th ~ U(50,100), U(-65,-55)
+  E_L = -70.0;
+  g_L = 16.6667;
+  E_ex = 0.0;
+  E_in = -85.0;
+  V_reset = -70.0;
+  t_ref = 2.0;
+  tau_ex = 0.2;
+  tau_in = 2.0;
+  PEx = std::exp(-h/tau_ex);
+  PIn = std::exp(-h/tau_in);
+  baseRate = 2.5;       // 2500 Hz poisson_generator [1/ms]
+  baseWeight = 10.0;
+  rewWeight = 1.0;
+  V.assign(nDopa, E_L);
+  C_m.resize(nDopa);
+  V_th.resize(nDopa);
+  gEx.assign(nDopa, 0);
+  dgEx.assign(nDopa, 0);
+  gIn.assign(nDopa, 0);
+  dgIn.assign(nDopa, 0);
+  refr.assign(nDopa, 0);
+  nextBase.resize(nDopa);
+  for (int i = 0; i < nDopa; ++i) {
+    C_m[i] = 50 + 50*(*numberGenerator)();
+    V_th[i] = -65 + 10*(*numberGenerator)();
+    nextBase[i] = -log(1 - (*numberGenerator)())/baseRate;
+  }
+
+  // stdp_dopamine_synapse
+  A_plus = 1e-6;
+  A_minus = 1e-6;
+  w_max = 1.;
+  w_min = 0.;
+  b = 31.783825818176656;
+  tau_c = 500.;
+  tau_n = 100.;
+  tau_plus = 10.;
+  tau_minus = 10.;
+  n = 0;
+  decayPlus = std::exp(-h/tau_plus);
+  decayMinus = std::exp(-h/tau_minus);
+  decayN = std::exp(-h/tau_n);
+  decayC = std::exp(-plasticPeriod*h/tau_c);
+  intN = (1 - std::exp(-plasticPeriod*h*(tau_c + tau_n)/(tau_c*tau_n)))*(tau_c*tau_n)/(tau_c + tau_n);
+  intB = tau_c*(1 - decayC);
+  kPlus.assign(nCells, 0);
+  kMinus.assign(nReadout, 0);
+
+  // Place Cells -> Critic/Actor all to all, w ~ U(0,1)
+  postSyn.resize(nReadout);
+  for (int i = 0; i < nCells; ++i) {
+    rowPtr.push_back(post.size());
+    for (int j = 0; j < nReadout; ++j) {
+      postSyn[j].push_back(post.size());
+      pre.push_back(i);
+      post.push_back(j);
+      w.push_back((*numberGenerator)());
+    }
+  }
+  rowPtr.push_back(post.size());
+  wStart = w;
+  c.assign(w.size(), 0);
+
+  // Actor lateral connectivity (N-winners take all)
+  double lat_max = 0.1,
+         lat_min = -0.06,
+         l = 0.05,
+         norm = std::exp(-std::pow(1,2)*std::pow(l,2));
+
+  for (int i = 0; i < nActor; ++i) {
+    latPtr.push_back(latPost.size());
+    for (int j = 0; j < nActor; ++j) {
+      if (i != j) {
+        latPost.push_back(j);
+        latW.push_back(lat_min + lat_max*std::exp(-std::pow(i-j,2)*std::pow(l,2))/norm);
+      }
+    }
+  }
+  latPtr.push_back(latPost.size());
+}
+
+SpikingAgent::~SpikingAgent()
+{
+  delete numberGenerator;
+  delete generator;
+  delete distribution;
+}
+
+void SpikingAgent::SetSender(Sender *_outhandler)
+{
+  outhandler = _outhandler;
+}
+
+double SpikingAgent::Time()
+{
+  return step*h/1000;
+}
+
+void SpikingAgent::SendState(arma::vec& q, double tickt)
+{
+  outhandler->SendState(q, tickt);
+}
+
+void SpikingAgent::SendReward(double reward, double tickt)
+{
+  outhandler->SendReward(reward, tickt);
+}
+
+void SpikingAgent::InsertEvent(double t, int id)
+{
+  // Input proxy -> parrot delay of 0.1 ms (one step)
+  long s = floor(t*1000/h + 1e-9) + 1;
+
+  if (s < step)
+    s = step;
+
+  inRing[s % ringSize].push_back(id);
+}
+
+void SpikingAgent::SetRate(int id, double rate)
+{
+  if (id >= rates.size())
+    rates.resize(id + 1, -1);
+
+  if (rates[id] < 0)
+    rateIds.push_back(id);
+
+  rates[id] = rate;
+}
+
+void SpikingAgent::DrawRates()
+{
+  double t, end = (step + stepsPerTick)*h;
+  int id;
+
+  // Same timing as InsertEvent: spike at t relayed one step later
+  for (int i = 0; i < rateIds.size(); ++i) {
+    id = rateIds[i];
+    if (rates[id] <= 0)
+      continue;
+
+    t = step*h - 1000*log(1 - (*numberGenerator)())/rates[id];
+    while (t < end) {
+      inRing[(long)(floor(t/h + 1e-9) + 1) % ringSize].push_back(id);
+      t -= 1000*log(1 - (*numberGenerator)())/rates[id];
+    }
+  }
+}
+
+double SpikingAgent::Tick()
+{
+  DrawRates();
+
+  for (int i = 0; i < stepsPerTick; ++i)
+    Update();
+
+  // Output proxy: spikes reach the environment
+  for (int i = 0; i < outId.size(); ++i)
+    inhandler->HandleEvent(outTime[i], outId[i]);
+  outId.clear();
+  outTime.clear();
+
+  return Time();
+}
+
+double SpikingAgent::GetAction(double tickt)
+{
+  return inhandler->GetAction(tickt);
+}
+
+double SpikingAgent::GetDopa(double tickt)
+{
+  return inhandler->GetDopa(tickt);
+}
+
+double* SpikingAgent::GetValue(double tickt, double reward)
+{
+  return inhandler->GetValue(tickt, reward);
+}
+
+void SpikingAgent::Update()
+{
+  int slot = step % ringSize,
+      rewEx = 0,
+      rewIn = 0;
+  double u, gt, Vinf;
+
+  // Place cells relay their channel, the two channels after them carry the reward
+  std::vector<int>& in = inRing[slot];
+  for (int i = 0; i < in.size(); ++i) {
+    if (in[i] < nCells)
+      PlaceCellSpike(in[i]);
+    else if (in[i] == nCells)
+      rewEx++;
+    else
+      rewIn++;
+  }
+  in.clear();
+
+  // Critic and Actor
+  std::vector<double>& inW = readoutRing[slot];
+  for (int i = 0; i < nReadout; ++i) {
+    vSyn[i] = vSyn[i]*P11 + iSyn[i]*P21;
+    vSpike[i] *= P30;
+    iSyn[i] = iSyn[i]*P11 + inW[i];
+    inW[i] = 0;
+
+    if (vSyn[i] + vSpike[i] >= U_th) {
+      vSpike[i] -= U_reset;
+      ReadoutSpike(i);
+    }
+  }
+
+  // Dopaminergic neurons
+  for (int i = 0; i < nDopa; ++i) {
+    u = rewEx*rewWeight;
+    while (nextBase[i] <= step*h) {
+      u += baseWeight;
+      nextBase[i] -= log(1 - (*numberGenerator)())/baseRate;
+    }
+    dgEx[i] += u*std::exp(1.0)/tau_ex;
+    dgIn[i] += rewIn*rewWeight*std::exp(1.0)/tau_in;
+
+    gEx[i] = PEx*(gEx[i] + h*dgEx[i]);
+    dgEx[i] *= PEx;
+    gIn[i] = PIn*(gIn[i] + h*dgIn[i]);
+    dgIn[i] *= PIn;
+
+    if (refr[i] > 0) {
+      refr[i] -= h;
+      V[i] = V_reset;
+      continue;
+    }
+
+    gt = g_L + gEx[i] + gIn[i];
+    Vinf = (g_L*E_L + gEx[i]*E_ex + gIn[i]*E_in)/gt;
+    V[i] = Vinf + (V[i] - Vinf)*std::exp(-h*gt/C_m[i]);
+
+    if (V[i] >= V_th[i]) {
+      V[i] = V_reset;
+      refr[i] = t_ref;
+      DopaSpike(i);
+    }
+  }
+
+  // Traces
+  for (int i = 0; i < nCells; ++i)
+    kPlus[i] *= decayPlus;
+  for (int i = 0; i < nReadout; ++i)
+    kMinus[i] *= decayMinus;
+  n *= decayN;
+
+  step++;
+  if (step % plasticPeriod == 0)
+    UpdateWeights();
+}
+
+void SpikingAgent::PlaceCellSpike(int i)
+{
+  // Plastic synapses, delay 0.1 ms; depression from the post-synaptic trace
+  std::vector<double>& outW = readoutRing[(step + 1) % ringSize];
+  for (int k = rowPtr[i]; k < rowPtr[i+1]; ++k) {
+    outW[post[k]] += w[k];
+    c[k] -= A_minus*kMinus[post[k]];
+  }
+  kPlus[i] += 1;
+}
+
+void SpikingAgent::ReadoutSpike(int i)
+{
+  // Facilitation from the pre-synaptic traces
+  for (int k = 0; k < postSyn[i].size(); ++k)
+    c[postSyn[i][k]] += A_plus*kPlus[pre[postSyn[i][k]]];
+  kMinus[i] += 1;
+
+  // Actor lateral connections
+  if (i >= nCritic) {
+    std::vector<double>& latIn = readoutRing[(step + lateralDelay) % ringSize];
+    for (int k = latPtr[i-nCritic]; k < latPtr[i-nCritic+1]; ++k)
+      latIn[nCritic + latPost[k]] += latW[k];
+  }
+
+  // Output proxy delay 0.1 ms
+  outId.push_back(i);
+  outTime.push_back(((step + 1)*h + 0.1)/1000);
+}
+
+void SpikingAgent::DopaSpike(int i)
+{
+  // Volume transmitter
+  n += 1/tau_n;
+
+  outId.push_back(nReadout + i);
+  outTime.push_back(((step + 1)*h + 0.1)/1000);
+}
+
+void SpikingAgent::UpdateWeights()
+{
+  // Exact integral of c(t)*(n(t) - b) over the plasticity period
+  double dn = n*intN,
+         db = b*intB;
+
+  for (int k = 0; k < w.size(); ++k) {
+    w[k] += c[k]*(dn - db);
+    if (w[k] > w_max)
+      w[k] = w_max;
+    else if (w[k] < w_min)
+      w[k] = w_min;
+    c[k] *= decayC;
+  }
+}
+
+void SpikingAgent::SaveNetwork(const std::string& folder)
+{
+  // Node ids follow the creation order of bee_classes.py (1-based)
+  arma::vec ids;
+  arma::mat conn;
+  int firstCritic = nCells + 1,
+      firstActor = firstCritic + nCritic,
+      first[] = {1, firstCritic, firstActor},
+      size[] = {nCells, nCritic, nActor};
+  std::string names[] = {"pCellsIDs.dat", "criticIDs.dat", "actorIDs.dat"};
+
+  for (int p = 0; p < 3; ++p) {
+    ids.zeros(size[p]);
+    for (int i = 0; i < size[p]; ++i)
+      ids(i) = first[p] + i;
+    ids.save(folder + names[p], arma::raw_ascii);
+  }
+
+  for (int p = 0; p < 2; ++p) {
+    int first = p ? nCritic : 0,
+        last = p ? nReadout : nCritic;
+    std::string name = folder + (p ? "connToActor" : "connToCritic");
+    ConnWriter writer(name + ".bin");
+
+    conn.zeros(nCells*(last - first), 4);
+    for (int k = 0, r = 0; k < w.size(); ++k) {
+      if (post[k] < first || post[k] >= last)
+        continue;
+      conn(r,0) = pre[k] + 1;
+      conn(r,1) = firstCritic + post[k];
+      conn(r,2) = wStart[k];
+      conn(r,3) = w[k];
+      writer.Append(conn(r,0), conn(r,1), conn(r,2), conn(r,3));
+      r++;
+    }
+    conn.save(name + ".dat", arma::raw_ascii);
+  }
+}
+
+void SpikingAgent::Save(std::ostream& out)
+{
+  Put(out, step);
+  PutEngine(out, *generator);
+  Put(out, inRing);
+  Put(out, rates);
+  Put(out, rateIds);
+  Put(out, iSyn);
+  Put(out, vSyn);
+  Put(out, vSpike);
+  Put(out, readoutRing);
+  Put(out, V);
+  Put(out, C_m);
+  Put(out, V_th);
+  Put(out, gEx);
+  Put(out, dgEx);
+  Put(out, gIn);
+  Put(out, dgIn);
+  Put(out, refr);
+  Put(out, nextBase);
+  Put(out, w);
+  Put(out, c);
+  Put(out, n);
+  Put(out, kPlus);
+  Put(out, kMinus);
+  outhandler->Save(out);
+  inhandler->Save(out, Time());
+}
+
+void SpikingAgent::Load(std::istream& in)
+{
+  Get(in, step);
+  GetEngine(in, *generator);
+  Get(in, inRing);
+  Get(in, rates);
+  Get(in, rateIds);
+  Get(in, iSyn);
+  Get(in, vSyn);
+  Get(in, vSpike);
+  Get(in, readoutRing);
+  Get(in, V);
+  Get(in, C_m);
+  Get(in, V_th);
+  Get(in, gEx);
+  Get(in, dgEx);
+  Get(in, gIn);
+  Get(in, dgIn);
+  Get(in, refr);
+  Get(in, nextBase);
+  Get(in, w);
+  Get(in, c);
+  Get(in, n);
+  Get(in, kPlus);
+  Get(in, kMinus);
+  outhandler->Load(in);
+  inhandler->Load(in);
+}
@@ -0,0 +1,90 @@
+/*
+ *  swarm.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "include/swarm.h"
+
+Swarm::Swarm(Agent *_clock, double _simt)
+{
+  clock = _clock;
+  simt = _simt;
+  plantPacer = NULL;
+  started = false;
+}
+
+Swarm::~Swarm() {}
+
+bool Swarm::Add(EpisodeRunner *runner)
+{
+  if (!runners.empty() && runner->Time() != runners[0]->Time())
+    return false;
+
+  runners.push_back(runner);
+
+  return true;
+}
+
+void Swarm::SetPacing(Pacer *plant)
+{
+  plantPacer = plant;
+}
+
+bool Swarm::Step()
+{
+  if (plantPacer && !started) {
+    plantPacer->Start();
+    started = true;
+  }
+
+  {
+    PROFILE_SCOPE("swarm step");
+
+    // Every bee runs on the same schedule
+    bool tick = runners.empty(), due;
+    for (int i = 0; i < runners.size(); ++i) {
+      due = runners[i]->Prepare();
+      if (i > 0 && due != tick)
+        return false;
+      tick = due;
+    }
+
+    if (tick) {
+      PROFILE_SCOPE("swarm tick");
+      clock->Tick();
+    }
+
+    for (int i = 0; i < runners.size(); ++i)
+      runners[i]->Complete(tick);
+  }
+
+  if (plantPacer)
+    plantPacer->Wait();
+
+  return true;
+}
+
+void Swarm::Finalize()
+{
+  for (int i = 0; i < runners.size(); ++i)
+    runners[i]->Finalize();
+
+  clock->Finalize();
+}
@@ -0,0 +1,152 @@
+/*
+ *  telemetry.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <sstream>
+#include <new>
+#include "include/telemetry.h"
+
+static const char telemetryMagic[8] = "RBTELE1";
+
+Telemetry::Telemetry(const std::string& _name, int capacity)
+{
+  std::ostringstream def;
+  def << "/robobee." << getpid();
+  name = _name.empty() ? def.str() : _name;
+
+  header = NULL;
+  slots = NULL;
+  count = 0;
+  size = sizeof(TelemetryHeader) + capacity*sizeof(TelemetrySlot);
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0)
+    return;
+
+  if (ftruncate(fd, size) == 0) {
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED)
+      header = (TelemetryHeader*)map;
+  }
+  close(fd);
+
+  if (!header) {
+    shm_unlink(name.c_str());
+    return;
+  }
+
+  slots = (TelemetrySlot*)(header + 1);
+  for (int i = 0; i < capacity; ++i)
+    new (&slots[i].seq) std::atomic<uint64_t>(0);
+  new (&header->written) std::atomic<uint64_t>(0);
+  header->capacity = capacity;
+  header->pid = getpid();
+
+  // Readers check the magic last
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(header->magic, telemetryMagic, sizeof(header->magic));
+}
+
+Telemetry::~Telemetry()
+{
+  if (!header)
+    return;
+
+  munmap(header, size);
+  shm_unlink(name.c_str());
+}
+
+void Telemetry::Publish(const TelemetrySample& sample)
+{
+  if (!header)
+    return;
+
+  TelemetrySlot& slot = slots[count % header->capacity];
+
+  slot.seq.store(2*count + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sample = sample;
+  slot.seq.store(2*count + 2, std::memory_order_release);
+
+  count++;
+  header->written.store(count, std::memory_order_release);
+}
+
+TelemetryReader::TelemetryReader(const std::string& name)
+{
+  struct stat info;
+
+  header = NULL;
+  slots = NULL;
+  size = 0;
+
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return;
+
+  if (fstat(fd, &info) == 0 && info.st_size >= sizeof(TelemetryHeader)) {
+    size = info.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED)
+      header = (TelemetryHeader*)map;
+  }
+  close(fd);
+
+  if (header && (memcmp(header->magic, telemetryMagic, sizeof(telemetryMagic)) != 0 ||
+                 sizeof(TelemetryHeader) + header->capacity*sizeof(TelemetrySlot) > size)) {
+    munmap(header, size);
+    header = NULL;
+  }
+
+  if (header)
+    slots = (TelemetrySlot*)(header + 1);
+}
+
+TelemetryReader::~TelemetryReader()
+{
+  if (header)
+    munmap(header, size);
+}
+
+bool TelemetryReader::Read(uint64_t n, TelemetrySample& sample)
+{
+  const TelemetrySlot& slot = slots[n % header->capacity];
+
+  uint64_t seq = slot.seq.load(std::memory_order_acquire);
+  if (seq != 2*n + 2)
+    return false;
+
+  sample = slot.sample;
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+uint64_t TelemetryReader::Oldest()
+{
+  uint64_t written = Written();
+
+  return written > header->capacity ? written - header->capacity : 0;
+}
@@ -0,0 +1,140 @@
+/*
+ *  traffic.cpp
+ *
+ *  This file is part of RoboBrain.
+ *  Copyright (C) 2016 Bernardo Fichera
+ *
+ *  RoboBrain is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RoboBrain is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RoboBrain.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <limits>
+#include <iomanip>
+#include <algorithm>
+#include "include/traffic.h"
+#include "include/profiler.h"
+
+Traffic::Traffic()
+  : waitBins(Profiler::NumBuckets, 0)
+{
+  oldest = std::numeric_limits<double>::infinity();
+  ticks = 0;
+  bytesOut = 0;
+  bytesIn = 0;
+  ageSum = 0;
+  ageMax = 0;
+  waitSum = 0;
+  waitMax = 0;
+
+  recorder = NULL;
+  channel = -1;
+}
+
+Traffic::~Traffic() {}
+
+int Traffic::AddGroup(const std::string& name, bool out)
+{
+  for (int i = 0; i < names.size(); ++i)
+    if (names[i] == name)
+      return i;
+
+  names.push_back(name);
+  outgoing.push_back(out);
+  counts.push_back(0);
+  totals.push_back(0);
+  peaks.push_back(0);
+
+  return names.size() - 1;
+}
+
+void Traffic::SetLog(Recorder *_recorder, const std::string& name, double rate)
+{
+  std::string columns = "t wait age";
+  for (int i = 0; i < names.size(); ++i)
+    columns += " " + names[i];
+  columns += " bytesOut bytesIn";
+
+  recorder = _recorder;
+  row.assign(names.size() + 5, 0);
+  channel = recorder->AddChannel(name, row.size(), rate, columns);
+}
+
+void Traffic::EndTick(double t, double wait)
+{
+  long out = 0, in = 0;
+  double age = oldest < t ? t - oldest : 0;
+  uint64_t ns = wait > 0 ? wait*1e9 : 0;
+
+  for (int i = 0; i < counts.size(); ++i) {
+    if (outgoing[i])
+      out += counts[i];
+    else
+      in += counts[i];
+    totals[i] += counts[i];
+    peaks[i] = std::max(peaks[i], counts[i]);
+    row[i + 3] = counts[i];
+    counts[i] = 0;
+  }
+
+  ticks++;
+  bytesOut += out*EventBytes;
+  bytesIn += in*EventBytes;
+  ageSum += age;
+  ageMax = std::max(ageMax, age);
+  waitSum += ns;
+  waitMax = std::max(waitMax, ns);
+  waitBins[Profiler::Bucket(ns)]++;
+  oldest = std::numeric_limits<double>::infinity();
+
+  if (recorder) {
+    row[0] = t;
+    row[1] = wait;
+    row[2] = age;
+    row[names.size() + 3] = out*EventBytes;
+    row[names.size() + 4] = in*EventBytes;
+    recorder->Record(channel, &row[0]);
+  }
+}
+
+void Traffic::Report(std::ostream& out)
+{
+  uint64_t p50 = 0, p99 = 0;
+  for (long b = 0, seen = 0; b < waitBins.size() && ticks > 0; ++b) {
+    seen += waitBins[b];
+    if (p50 == 0 && seen >= 0.5*ticks)
+      p50 = std::min<uint64_t>(Profiler::BucketTop(b), waitMax);
+    if (seen >= 0.99*ticks) {
+      p99 = std::min<uint64_t>(Profiler::BucketTop(b), waitMax);
+      break;
+    }
+  }
+
+  out << std::setw(20) << "Group"
+      << std::setw(6) << "Dir"
+      << std::setw(14) << "Events"
+      << std::setw(14) << "Mean/tick"
+      << std::setw(14) << "Max/tick" << std::endl;
+  for (int i = 0; i < names.size(); ++i)
+    out << std::setw(20) << names[i]
+        << std::setw(6) << (outgoing[i] ? "out" : "in")
+        << std::setw(14) << totals[i]
+        << std::setw(14) << (ticks ? (double)totals[i]/ticks : 0)
+        << std::setw(14) << peaks[i] << std::endl;
+
+  out << ticks << " ticks, " << bytesOut << " bytes out, " << bytesIn << " bytes in" << std::endl
+      << "tick wait " << (ticks ? 1e-3*waitSum/ticks : 0) << "/" << 1e-3*p50 << "/" << 1e-3*p99
+      << "/" << 1e-3*waitMax << " us mean/p50/p99/max" << std::endl
+      << "spike age " << (ticks ? 1e3*ageSum/ticks : 0) << "/" << 1e3*ageMax << " ms mean/max" << std::endl;
+}